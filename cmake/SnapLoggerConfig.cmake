@@ -52,6 +52,18 @@ mark_as_advanced(
 set(SNAPLOGGER_INCLUDE_DIRS ${SNAPLOGGER_INCLUDE_DIR})
 set(SNAPLOGGER_LIBRARIES    ${SNAPLOGGER_LIBRARY})
 
+# the library was compiled against {fmt} if <format> was not available
+#
+if(SNAPLOGGER_INCLUDE_DIR)
+    file(STRINGS ${SNAPLOGGER_INCLUDE_DIR}/snaplogger/version.h SNAPLOGGER_USE_FMT
+        REGEX "^#define SNAPLOGGER_USE_FMT")
+    if(SNAPLOGGER_USE_FMT)
+        find_library(SNAPLOGGER_FMT_LIBRARY fmt)
+        mark_as_advanced(SNAPLOGGER_FMT_LIBRARY)
+        list(APPEND SNAPLOGGER_LIBRARIES ${SNAPLOGGER_FMT_LIBRARY})
+    endif()
+endif()
+
 
 include(FindPackageHandleStandardArgs)
 find_package_handle_standard_args(
@@ -32,9 +32,13 @@
 #include    "snaplogger/private_logger.h"
 
 
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
 // snapdev
 //
-#include    <snapdev/empty_set_intersection.h>
 #include    <snapdev/not_used.h>
 
 
@@ -68,6 +72,73 @@ namespace
 //APPENDER_FACTORY(null);
 
 
+// a thread keeps a buffer larger than this only while rendering a
+// message; that way one very large message does not hold on that much
+// memory forever
+//
+constexpr std::size_t const     MAX_KEPT_BUFFER_SIZE = 64 * 1024;
+
+
+/** \brief The buffer used to render messages in this thread.
+ *
+ * The formatted messages get rendered in this buffer so its memory is
+ * reused from one message to the next.
+ */
+struct render_buffer
+{
+    std::string         f_buffer = std::string();
+    bool                f_in_use = false;
+};
+
+
+thread_local render_buffer      g_render_buffer = render_buffer();
+
+
+/** \brief Use the render buffer of this thread.
+ *
+ * If an appender ends up sending a message while rendering one (i.e. an
+ * error while writing its output), the thread buffer is already in use.
+ * In that case, this object gives a local string instead.
+ */
+class render_buffer_use
+{
+public:
+    render_buffer_use()
+        : f_reused(!g_render_buffer.f_in_use)
+    {
+        if(f_reused)
+        {
+            g_render_buffer.f_in_use = true;
+            g_render_buffer.f_buffer.clear();
+        }
+    }
+
+    render_buffer_use(render_buffer_use const &) = delete;
+    render_buffer_use & operator = (render_buffer_use const &) = delete;
+
+    ~render_buffer_use()
+    {
+        if(f_reused)
+        {
+            if(g_render_buffer.f_buffer.capacity() > MAX_KEPT_BUFFER_SIZE)
+            {
+                std::string().swap(g_render_buffer.f_buffer);
+            }
+            g_render_buffer.f_in_use = false;
+        }
+    }
+
+    std::string & buffer()
+    {
+        return f_reused ? g_render_buffer.f_buffer : f_local;
+    }
+
+private:
+    bool const          f_reused;
+    std::string         f_local = std::string();
+};
+
+
 }
 
 
@@ -78,7 +149,7 @@ appender::appender(std::string const & name, std::string const & type)
 {
     guard g;
 
-    f_format = get_private_logger()->get_default_format();
+    f_format.store(get_private_logger()->get_default_format());
 }
 
 
@@ -108,6 +179,7 @@ void appender::set_name(std::string const & name)
     }
 
     f_name = name;
+    logger::get_instance()->appender_changed();
 }
 
 
@@ -121,17 +193,13 @@ std::string const & appender::get_name() const
 
 bool appender::is_enabled() const
 {
-    guard g;
-
-    return f_enabled;
+    return f_enabled.load(std::memory_order_relaxed);
 }
 
 
 void appender::set_enabled(bool status)
 {
-    guard g;
-
-    f_enabled = status;
+    f_enabled.store(status, std::memory_order_relaxed);
 }
 
 
@@ -143,9 +211,7 @@ bool appender::unique() const
 
 severity_t appender::get_severity() const
 {
-    guard g;
-
-    return f_severity;
+    return f_severity.load(std::memory_order_relaxed);
 }
 
 
@@ -153,7 +219,7 @@ void appender::set_severity(severity_t severity_level)
 {
     guard g;
 
-    f_severity = severity_level;
+    f_severity.store(severity_level, std::memory_order_relaxed);
     logger::get_instance()->severity_changed(severity_level);
 }
 
@@ -162,7 +228,7 @@ void appender::reduce_severity(severity_t severity_level)
 {
     guard g;
 
-    if(severity_level < f_severity)
+    if(severity_level < get_severity())
     {
         set_severity(severity_level);
     }
@@ -173,7 +239,7 @@ void appender::increase_severity(severity_t severity_level)
 {
     guard g;
 
-    if(severity_level > f_severity)
+    if(severity_level > get_severity())
     {
         set_severity(severity_level);
     }
@@ -182,9 +248,7 @@ void appender::increase_severity(severity_t severity_level)
 
 bool appender::operator < (appender const & rhs) const
 {
-    guard g;
-
-    return f_severity < rhs.f_severity;
+    return get_severity() < rhs.get_severity();
 }
 
 
@@ -198,15 +262,15 @@ void appender::set_config(advgetopt::getopt const & opts)
         std::string const specialized_enabled(f_name + "::enabled");
         if(opts.is_defined(specialized_enabled))
         {
-            f_enabled = !advgetopt::is_false(opts.get_string(specialized_enabled));
+            set_enabled(!advgetopt::is_false(opts.get_string(specialized_enabled)));
         }
         else if(opts.is_defined("enabled"))
         {
-            f_enabled = !advgetopt::is_false(opts.get_string("enabled"));
+            set_enabled(!advgetopt::is_false(opts.get_string("enabled")));
         }
         else
         {
-            f_enabled = true;
+            set_enabled(true);
         }
     }
 
@@ -216,11 +280,11 @@ void appender::set_config(advgetopt::getopt const & opts)
         std::string const specialized_format(f_name + "::format");
         if(opts.is_defined(specialized_format))
         {
-            f_format = std::make_shared<format>(opts.get_string(specialized_format));
+            f_format.store(get_shared_format(opts.get_string(specialized_format)));
         }
         else if(opts.is_defined("format"))
         {
-            f_format = std::make_shared<format>(opts.get_string("format"));
+            f_format.store(get_shared_format(opts.get_string("format")));
         }
     }
 
@@ -255,7 +319,7 @@ void appender::set_config(advgetopt::getopt const & opts)
             //
             rate = rate * (60.0 * 1'000'000.0 / 8.0);
         }
-        f_bytes_per_minute = static_cast<decltype(f_bytes_per_minute)>(floor(rate));
+        f_bytes_per_minute.store(static_cast<long>(floor(rate)), std::memory_order_relaxed);
     }
 
     // SEVERITY
@@ -464,7 +528,7 @@ void appender::set_config(advgetopt::getopt const & opts)
                     }
                 }
             }
-            f_filter = std::make_shared<std::regex>(filter, flags | type);
+            f_filter.store(std::make_shared<std::regex>(filter, flags | type));
         }
     }
 
@@ -491,19 +555,23 @@ void appender::set_config(advgetopt::getopt const & opts)
                 if(value == "max"
                 || value == "maximum")
                 {
-                    f_no_repeat_size = NO_REPEAT_MAXIMUM;
+                    f_no_repeat_size.store(NO_REPEAT_MAXIMUM, std::memory_order_relaxed);
                 }
                 else if(value == "default")
                 {
-                    f_no_repeat_size = NO_REPEAT_DEFAULT;
+                    f_no_repeat_size.store(NO_REPEAT_DEFAULT, std::memory_order_relaxed);
                 }
                 else
                 {
-                    f_no_repeat_size = opts.get_long(no_repeat, 0, 0, NO_REPEAT_MAXIMUM);
+                    f_no_repeat_size.store(opts.get_long(no_repeat, 0, 0, NO_REPEAT_MAXIMUM), std::memory_order_relaxed);
                 }
             }
         }
     }
+
+    // the fallback only flag and fallbacks may have changed
+    //
+    logger::get_instance()->appender_changed();
 }
 
 
@@ -512,11 +580,67 @@ void appender::reopen()
 }
 
 
+/** \brief Add a component to this appender.
+ *
+ * The mask of components is never modified in place. A new mask is
+ * created and it replaces the old one so messages being sent on other
+ * threads can continue to use the old mask without locking.
+ *
+ * \param[in] comp  The component to add.
+ */
 void appender::add_component(component::pointer_t comp)
 {
     guard g;
 
-    f_components.insert(comp);
+    component_mask_pointer_t current(f_components.load());
+    if(current != nullptr
+    && current->test(comp->get_index()))
+    {
+        return;
+    }
+
+    std::shared_ptr<component::mask_t> components(std::make_shared<component::mask_t>());
+    if(current != nullptr)
+    {
+        *components = *current;
+    }
+    components->set(comp->get_index());
+    f_components.store(components);
+
+    logger::get_instance()->appender_changed();
+}
+
+
+/** \brief Get the components accepted by this appender.
+ *
+ * This function converts the mask of components to a set. It is kept
+ * for compatibility, use get_component_mask() instead.
+ *
+ * \return The set of components or a null pointer if none were added.
+ */
+component_set_pointer_t appender::get_components() const
+{
+    component_mask_pointer_t const components(f_components.load());
+    if(components == nullptr)
+    {
+        return component_set_pointer_t();
+    }
+    return std::make_shared<component::set_t const>(to_component_set(*components));
+}
+
+
+/** \brief Get the mask of components accepted by this appender.
+ *
+ * \return The mask of components, empty if none were added.
+ */
+component::mask_t appender::get_component_mask() const
+{
+    component_mask_pointer_t const components(f_components.load());
+    if(components == nullptr)
+    {
+        return component::mask_t();
+    }
+    return *components;
 }
 
 
@@ -531,6 +655,7 @@ bool appender::add_fallback_appender(std::string const & name)
     if(it == f_fallback_appenders.end())
     {
         f_fallback_appenders.push_back(name);
+        logger::get_instance()->appender_changed();
         return true;
     }
 
@@ -549,6 +674,7 @@ bool appender::remove_fallback_appender(std::string const & name)
     if(it != f_fallback_appenders.end())
     {
         f_fallback_appenders.erase(it);
+        logger::get_instance()->appender_changed();
         return true;
     }
 
@@ -566,31 +692,25 @@ advgetopt::string_list_t appender::get_fallback_appenders() const
 
 bool appender::is_fallback_only() const
 {
-    return f_fallback_only;
+    return f_fallback_only.load(std::memory_order_relaxed);
 }
 
 
 format::pointer_t appender::get_format() const
 {
-    guard g;
-
-    return f_format;
+    return f_format.load();
 }
 
 
 format::pointer_t appender::set_format(format::pointer_t new_format)
 {
-    guard g;
-
-    format::pointer_t old(f_format);
-    f_format = new_format;
-    return old;
+    return f_format.exchange(new_format);
 }
 
 
 long appender::get_bytes_per_minute() const
 {
-    return f_bytes_per_minute;
+    return f_bytes_per_minute.load(std::memory_order_relaxed);
 }
 
 
@@ -618,7 +738,7 @@ long appender::get_bytes_per_minute() const
  */
 std::size_t appender::get_bitrate_dropped_messages() const
 {
-    return f_bitrate_dropped_messages;
+    return f_bitrate_dropped_messages.load(std::memory_order_relaxed);
 }
 
 
@@ -632,46 +752,83 @@ std::size_t appender::get_bitrate_dropped_messages() const
  * considered that it worked. In other words, the function
  * returns true.
  *
+ * \param[in] msg  The message to send.
+ *
  * \return true if the message was successfully processed.
+ *
+ * \sa send_routed_message()
  */
 bool appender::send_message(message const & msg)
 {
-    if(!is_enabled()
-    || msg.get_severity() < f_severity)
+    if(msg.get_severity() < get_severity())
     {
         return true;
     }
 
-    guard g;
-
-    component::set_t const & components(msg.get_components());
-    if(components.empty())
+    component_mask_pointer_t const appender_components(f_components.load());
+    component::mask_t const & components(msg.get_component_mask());
+    if(components.none())
     {
         // user did not supply any component in 'msg', check for
         // the normal component
         //
-        if(!f_components.empty()
-        && f_components.find(f_normal_component) == f_components.end())
+        if(appender_components != nullptr
+        && appender_components->any()
+        && !appender_components->test(f_normal_component->get_index()))
         {
             return true;
         }
     }
     else
     {
-        if(snapdev::empty_set_intersection(f_components, components))
+        if(appender_components == nullptr
+        || (*appender_components & components).none())
         {
             return true;
         }
     }
 
-    std::string formatted_message(f_format->process_message(msg));
+    return send_routed_message(msg);
+}
+
+
+/** \brief Send a message which this appender accepts.
+ *
+ * The logger uses its routing table to determine which appenders accept
+ * a message depending on its severity and components. It then calls
+ * this function directly, which skips those verifications.
+ *
+ * The filtering and formatting happen without any lock so several
+ * threads can work on their messages at the same time. Only the
+ * bitrate and no-repeat state and the call to process_message()
+ * are protected by this appender mutex.
+ *
+ * The message gets rendered in a buffer which the thread reuses for
+ * each message.
+ *
+ * \param[in] msg  The message to send.
+ *
+ * \return true if the message was successfully processed.
+ */
+bool appender::send_routed_message(message const & msg)
+{
+    if(!is_enabled())
+    {
+        return true;
+    }
+
+    format::pointer_t const message_format(get_format());
+    render_buffer_use render;
+    std::string & formatted_message(render.buffer());
+    message_format->process_message(msg, formatted_message);
     if(formatted_message.empty())
     {
         return true;
     }
 
-    if(f_filter != nullptr
-    && !std::regex_match(formatted_message, *f_filter))
+    regex_pointer_t const filter(f_filter.load());
+    if(filter != nullptr
+    && !std::regex_match(formatted_message, *filter))
     {
         return true;
     }
@@ -684,9 +841,19 @@ bool appender::send_message(message const & msg)
         formatted_message += '\n';
     }
 
+    std::size_t const no_repeat_size(f_no_repeat_size.load(std::memory_order_relaxed));
+    std::string non_changing_message;
+    if(no_repeat_size > NO_REPEAT_OFF)
+    {
+        non_changing_message = message_format->process_message(msg, true);
+    }
+
+    cppthread::guard lock(f_mutex);
+
     // TBD: should we use the time of the message rather than 'now'?
     //
-    if(f_bytes_per_minute != 0)
+    long const bytes_per_minute(get_bytes_per_minute());
+    if(bytes_per_minute != 0)
     {
         time_t const current_minute(time(0) / 60);
         if(current_minute != f_bytes_minute)
@@ -695,7 +862,7 @@ bool appender::send_message(message const & msg)
             f_bytes_received = 0;
         }
         else if(f_bytes_received + static_cast<long>(formatted_message.length())
-                                        >= f_bytes_per_minute)
+                                        >= bytes_per_minute)
         {
             // overflow
             //
@@ -709,9 +876,8 @@ bool appender::send_message(message const & msg)
         f_bytes_received += formatted_message.length();
     }
 
-    if(f_no_repeat_size > NO_REPEAT_OFF)
+    if(no_repeat_size > NO_REPEAT_OFF)
     {
-        std::string const non_changing_message(f_format->process_message(msg, true));
         auto it(std::find(f_last_messages.rbegin(), f_last_messages.rend(), non_changing_message));
         if(it != f_last_messages.rend())
         {
@@ -738,8 +904,8 @@ bool appender::send_message(message const & msg)
             //
             return true;
         }
-        f_last_messages.push_back(non_changing_message);
-        if(f_last_messages.size() > f_no_repeat_size)
+        f_last_messages.push_back(std::move(non_changing_message));
+        if(f_last_messages.size() > no_repeat_size)
         {
             f_last_messages.pop_front();
         }
@@ -749,6 +915,20 @@ bool appender::send_message(message const & msg)
 }
 
 
+/** \brief Get the mutex protecting the output of this appender.
+ *
+ * The process_message() function is always called with this mutex
+ * locked. Appenders which modify their output in other functions
+ * (i.e. reopen()) must lock it too.
+ *
+ * \return A reference to the appender mutex.
+ */
+cppthread::mutex & appender::get_mutex() const
+{
+    return f_mutex;
+}
+
+
 bool appender::process_message(message const & msg, std::string const & formatted_message)
 {
     // the default is a "null appender" -- do nothing, always successful
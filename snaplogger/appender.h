@@ -21,6 +21,12 @@
  * \brief Appenders are used to append data to somewhere.
  *
  * This file declares the base appender class.
+ *
+ * The parameters used to filter and format a message are read without
+ * any lock so many threads can format messages in parallel. Only the
+ * final output is protected by a mutex, one per appender. The global
+ * guard may be locked while holding an appender mutex, but an appender
+ * mutex must never be locked while holding the global guard.
  */
 
 // self
@@ -34,8 +40,14 @@
 #include    <advgetopt/utils.h>
 
 
+// cppthread
+//
+#include    <cppthread/mutex.h>
+
+
 // C++
 //
+#include    <atomic>
 #include    <regex>
 #include    <vector>
 
@@ -46,6 +58,10 @@ namespace snaplogger
 
 
 typedef std::shared_ptr<std::regex>         regex_pointer_t;
+typedef std::shared_ptr<component::set_t const>
+                                            component_set_pointer_t;
+typedef std::shared_ptr<component::mask_t const>
+                                            component_mask_pointer_t;
 
 constexpr long const                        NO_REPEAT_OFF     = 0;
 constexpr long const                        NO_REPEAT_MAXIMUM = 100;
@@ -81,6 +97,8 @@ public:
     virtual void                set_config(advgetopt::getopt const & params);
     virtual void                reopen();
     void                        add_component(component::pointer_t comp);
+    component_set_pointer_t     get_components() const;
+    component::mask_t           get_component_mask() const;
     bool                        add_fallback_appender(std::string const & name);
     bool                        remove_fallback_appender(std::string const & name);
     advgetopt::string_list_t    get_fallback_appenders() const;
@@ -93,27 +111,38 @@ public:
     std::size_t                 get_bitrate_dropped_messages() const;
 
     bool                        send_message(message const & msg);
+    bool                        send_routed_message(message const & msg);
 
 protected:
+    cppthread::mutex &          get_mutex() const;
     virtual bool                process_message(message const & msg, std::string const & formatted_message);
 
 private:
+    // read on each message without locks
+    //
     std::string const           f_type;
     std::string                 f_name = std::string();
-    bool                        f_enabled = true;
-    format::pointer_t           f_format = format::pointer_t();
-    severity_t                  f_severity = severity_t::SEVERITY_DEFAULT;
+    std::atomic<bool>           f_enabled = true;
+    std::atomic<format::pointer_t>
+                                f_format = format::pointer_t();
+    std::atomic<severity_t>     f_severity = severity_t::SEVERITY_DEFAULT;
     component::pointer_t        f_normal_component = component::pointer_t();
-    component::set_t            f_components = component::set_t();
+    std::atomic<component_mask_pointer_t>
+                                f_components = component_mask_pointer_t();
     advgetopt::string_list_t    f_fallback_appenders = advgetopt::string_list_t();
-    regex_pointer_t             f_filter = regex_pointer_t();
-    std::size_t                 f_no_repeat_size = NO_REPEAT_OFF;
+    std::atomic<regex_pointer_t>
+                                f_filter = regex_pointer_t();
+    std::atomic<std::size_t>    f_no_repeat_size = NO_REPEAT_OFF;
+    std::atomic<long>           f_bytes_per_minute = 0;
+    std::atomic<std::size_t>    f_bitrate_dropped_messages = 0;
+    std::atomic<bool>           f_fallback_only = false;
+
+    // protected by f_mutex
+    //
+    mutable cppthread::mutex    f_mutex = cppthread::mutex();
     std::deque<std::string>     f_last_messages = {};
-    long                        f_bytes_per_minute = 0;
     long                        f_bytes_received = 0;
     time_t                      f_bytes_minute = 0;
-    std::size_t                 f_bitrate_dropped_messages = 0;
-    bool                        f_fallback_only = false;
 };
 
 
@@ -22,8 +22,6 @@
 //
 #include    "snaplogger/buffer_appender.h"
 
-#include    "snaplogger/guard.h"
-
 
 // snapdev
 //
@@ -76,8 +74,6 @@ bool buffer_appender::process_message(message const & msg, std::string const & f
 {
     snapdev::NOT_USED(msg);
 
-    guard g;
-
     *this << formatted_message;
     return true;
 }
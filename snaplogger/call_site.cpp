@@ -0,0 +1,220 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/snaplogger
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Implementation of the call site descriptors.
+ *
+ * The call sites are static objects created by the SNAP_LOG_...() macros.
+ * They get registered in the module of their translation unit and the
+ * modules are linked together in a process wide list. A module removes
+ * itself from that list when destroyed, so a plugin being unloaded does
+ * not leave dangling call sites behind.
+ *
+ * The list is protected by a std::mutex which, unlike the logger guard,
+ * is constant initialized and can be used during the static
+ * initialization and destruction of the process.
+ */
+
+// self
+//
+#include    "snaplogger/call_site.h"
+
+
+// C++
+//
+#include    <mutex>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace snaplogger
+{
+
+
+namespace
+{
+
+
+
+std::mutex                  g_mutex = std::mutex();
+call_site_module *          g_modules = nullptr;
+
+
+
+}
+// no name namespace
+
+
+
+/** \brief Initialize and register a call site.
+ *
+ * The severity is the one of the first message sent from this call site.
+ * It is only informational since a call site such as SNAP_LOG_DEFAULT
+ * may use a different severity each time.
+ *
+ * The call site only keeps pointers to the strings of \p location,
+ * which are static. It is expected to be a static variable defined
+ * next to the SNAP_LOG_...() statement. A message which references a
+ * call site defined in a plugin must be processed before that plugin
+ * gets unloaded.
+ *
+ * \param[in] sev  The severity of the message.
+ * \param[in] location  The location of the SNAP_LOG_...() statement.
+ * \param[in] module  The module of the translation unit defining this
+ * call site.
+ */
+call_site::call_site(
+          severity_t sev
+        , std::source_location const & location
+        , call_site_module & module)
+    : f_severity(sev)
+    , f_filename(location.file_name())
+    , f_funcname(location.function_name())
+    , f_line(location.line())
+    , f_column(location.column())
+{
+    module.add(this);
+}
+
+
+severity_t call_site::get_severity() const
+{
+    return f_severity;
+}
+
+
+char const * call_site::get_filename() const
+{
+    return f_filename;
+}
+
+
+char const * call_site::get_function() const
+{
+    return f_funcname;
+}
+
+
+std::uint_least32_t call_site::get_line() const
+{
+    return f_line;
+}
+
+
+std::uint_least32_t call_site::get_column() const
+{
+    return f_column;
+}
+
+
+
+/** \brief Unregister the call sites of this module.
+ *
+ * The module gets destroyed when the process exits or when the plugin
+ * it is part of gets unloaded. Its call sites are removed from the list
+ * returned by get_call_sites() and any call site created after this
+ * point does not get registered.
+ */
+call_site_module::~call_site_module()
+{
+    std::lock_guard lock(g_mutex);
+
+    f_destroyed = true;
+    f_sites = nullptr;
+    if(f_registered)
+    {
+        if(f_previous == nullptr)
+        {
+            g_modules = f_next;
+        }
+        else
+        {
+            f_previous->f_next = f_next;
+        }
+        if(f_next != nullptr)
+        {
+            f_next->f_previous = f_previous;
+        }
+        f_registered = false;
+    }
+}
+
+
+/** \brief Add a call site to this module.
+ *
+ * The first call site of a module also registers the module itself in
+ * the process wide list.
+ *
+ * \param[in] site  The call site to add.
+ */
+void call_site_module::add(call_site const * site)
+{
+    std::lock_guard lock(g_mutex);
+
+    if(f_destroyed)
+    {
+        return;
+    }
+
+    if(!f_registered)
+    {
+        f_next = g_modules;
+        if(f_next != nullptr)
+        {
+            f_next->f_previous = this;
+        }
+        g_modules = this;
+        f_registered = true;
+    }
+
+    site->f_next = f_sites;
+    f_sites = site;
+}
+
+
+/** \brief Retrieve the call sites registered so far.
+ *
+ * A call site gets registered the first time its SNAP_LOG_...()
+ * statement gets executed. Within a module, the call sites are listed
+ * in reverse order of registration.
+ *
+ * \return A vector of pointers to all the registered call sites.
+ */
+call_site::vector_t get_call_sites()
+{
+    std::lock_guard lock(g_mutex);
+
+    call_site::vector_t result;
+    for(call_site_module const * m(g_modules); m != nullptr; m = m->f_next)
+    {
+        for(call_site const * s(m->f_sites); s != nullptr; s = s->f_next)
+        {
+            result.push_back(s);
+        }
+    }
+    return result;
+}
+
+
+
+} // snaplogger namespace
+// vim: ts=4 sw=4 et
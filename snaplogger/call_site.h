@@ -0,0 +1,150 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/snaplogger
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+/** \file
+ * \brief Static descriptors of the places where messages get logged.
+ *
+ * Each SNAP_LOG_...() statement creates one call site the first time
+ * it gets executed. The call site holds the filename, function name,
+ * line, and column of the statement so messages only have to keep a
+ * pointer to it instead of copying those strings each time.
+ *
+ * A call site is trivially destructible. It only points to the static
+ * strings of the std::source_location so it remains usable while other
+ * static objects get destroyed at exit.
+ *
+ * The call sites get registered in the call_site_module of the
+ * translation unit where they are defined. That module is a static
+ * object which unregisters all of its call sites when it gets destroyed,
+ * i.e. when the process exits or when the plugin it is part of gets
+ * unloaded. The get_call_sites() function enumerates the call sites of
+ * all the modules still registered.
+ */
+
+// self
+//
+#include    <snaplogger/severity.h>
+
+
+// C++
+//
+#include    <source_location>
+#include    <type_traits>
+#include    <vector>
+
+
+
+namespace snaplogger
+{
+
+
+
+class call_site_module;
+
+
+class call_site
+{
+public:
+    typedef std::vector<call_site const *>      vector_t;
+
+                                call_site(
+                                      severity_t sev
+                                    , std::source_location const & location
+                                    , call_site_module & module);
+                                call_site(call_site const & rhs) = delete;
+
+    call_site &                 operator = (call_site const & rhs) = delete;
+
+    severity_t                  get_severity() const;
+    char const *                get_filename() const;
+    char const *                get_function() const;
+    std::uint_least32_t         get_line() const;
+    std::uint_least32_t         get_column() const;
+
+private:
+    severity_t const            f_severity;
+    char const * const          f_filename;
+    char const * const          f_funcname;
+    std::uint_least32_t const   f_line;
+    std::uint_least32_t const   f_column;
+    mutable call_site const *   f_next = nullptr;
+
+    friend class call_site_module;
+    friend call_site::vector_t  get_call_sites();
+};
+
+
+static_assert(std::is_trivially_destructible_v<call_site>);
+
+
+class call_site_module
+{
+public:
+    constexpr                   call_site_module() = default;
+                                call_site_module(call_site_module const & rhs) = delete;
+                                ~call_site_module();
+
+    call_site_module &          operator = (call_site_module const & rhs) = delete;
+
+    void                        add(call_site const * site);
+
+private:
+    call_site const *           f_sites = nullptr;
+    call_site_module *          f_previous = nullptr;
+    call_site_module *          f_next = nullptr;
+    bool                        f_registered = false;
+    bool                        f_destroyed = false;
+
+    friend call_site::vector_t  get_call_sites();
+};
+
+
+call_site::vector_t             get_call_sites();
+
+
+namespace detail
+{
+namespace
+{
+// each translation unit gets its own module; it is constant initialized
+// so call sites can be registered during the static initialization
+//
+[[maybe_unused]] constinit call_site_module g_call_site_module = call_site_module();
+}
+// no name namespace
+}
+// detail namespace
+
+
+
+// the lambda gives each SNAP_LOG_...() statement its own static call site
+// which gets created and registered in the module of the translation unit
+// the first time the statement runs
+//
+#define SNAP_LOG_CALL_SITE(sev) \
+    [](::snaplogger::severity_t s, std::source_location const & location) -> ::snaplogger::call_site const & \
+    { \
+        static ::snaplogger::call_site const site(s, location, ::snaplogger::detail::g_call_site_module); \
+        return site; \
+    }((sev), std::source_location::current())
+
+
+
+} // snaplogger namespace
+// vim: ts=4 sw=4 et
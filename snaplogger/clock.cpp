@@ -0,0 +1,416 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/snaplogger
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Implementation of the message clock sources.
+ *
+ * The TSC clock gets calibrated against CLOCK_MONOTONIC_RAW the first
+ * time it gets selected. That clock is not adjusted by NTP so a slew or
+ * a step during the calibration does not skew the rate. The TSC is then
+ * anchored to CLOCK_REALTIME and that anchor gets refreshed about once
+ * per second, along the rate, so the timestamps follow the NTP
+ * adjustments and do not drift away from the wall time.
+ */
+
+// self
+//
+#include    "snaplogger/clock.h"
+
+
+// C++
+//
+#include    <limits>
+#include    <memory>
+#include    <mutex>
+
+
+// C
+//
+#if defined(__x86_64__) || defined(__i386__)
+#include    <cpuid.h>
+#include    <x86intrin.h>
+#endif
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace snaplogger
+{
+
+
+namespace
+{
+
+
+
+constexpr std::int64_t const    g_nanoseconds_per_second = 1'000'000'000LL;
+
+
+/** \brief The interval between two anchors of the TSC to the realtime clock.
+ *
+ * The rate computed by the calibration has an error of a few ppm. Anchoring
+ * the TSC again each second bounds the drift to a few microseconds and
+ * lets the timestamps follow the NTP adjustments of CLOCK_REALTIME.
+ */
+constexpr std::int64_t const    g_anchor_interval = g_nanoseconds_per_second;
+
+
+/** \brief The largest backward step hidden by tsc_to_timespec().
+ *
+ * A new anchor may convert a TSC value a few microseconds earlier than
+ * the previous anchor did, and a TSC value read before another may get
+ * converted after it. In both cases, the timestamp would go back in
+ * time. To avoid that, a timestamp is never earlier than the last one
+ * produced, as long as the difference is at most this many nanoseconds.
+ * A timestamp can therefore be late by up to this amount, although the
+ * re-anchoring differences are in the order of a few microseconds.
+ *
+ * A larger difference is viewed as a change of the realtime clock
+ * (i.e. the administrator set the date back) and the timestamps
+ * follow it as they do with the other clock sources.
+ */
+constexpr std::int64_t const    g_maximum_backward_step = 1'000'000LL;
+
+
+/** \brief A TSC value along the corresponding realtime clock.
+ *
+ * The anchor is immutable. A new one gets published each time the
+ * TSC gets anchored again.
+ */
+struct tsc_anchor
+{
+    typedef std::shared_ptr<tsc_anchor const>   pointer_t;
+
+    std::uint64_t       f_tsc = 0;
+    std::int64_t        f_ns = 0;
+    double              f_ns_per_tick = 0.0;
+};
+
+
+/** \brief The first TSC and CLOCK_MONOTONIC_RAW pair.
+ *
+ * The rate gets computed again from this pair each time the TSC gets
+ * anchored. The longer the interval, the more precise the rate.
+ */
+struct tsc_origin
+{
+    std::uint64_t       f_tsc = 0;
+    std::int64_t        f_raw_ns = 0;
+};
+
+
+std::once_flag                      g_calibrate_once = std::once_flag();
+bool                                g_calibrated = false;
+tsc_origin                          g_origin = tsc_origin();
+std::atomic<tsc_anchor::pointer_t>  g_anchor = tsc_anchor::pointer_t();
+std::atomic<std::uint64_t>          g_next_anchor_tsc = 0;
+std::atomic<std::int64_t>           g_last_ns = 0;
+
+
+std::int64_t clock_ns(clockid_t clock)
+{
+    timespec now;
+    clock_gettime(clock, &now);
+    return now.tv_sec * g_nanoseconds_per_second + now.tv_nsec;
+}
+
+
+/** \brief Read the TSC and a clock at the same time.
+ *
+ * The TSC is read before and after the clock_gettime() call and the
+ * average is used so the pair is as close as possible.
+ *
+ * \param[in] clock  The clock to read along the TSC.
+ * \param[out] tsc  The TSC value.
+ * \param[out] ns  The clock in nanoseconds.
+ */
+void read_pair(clockid_t clock, std::uint64_t & tsc, std::int64_t & ns)
+{
+    std::uint64_t const before(detail::read_tsc());
+    ns = clock_ns(clock);
+    std::uint64_t const after(detail::read_tsc());
+    tsc = before + (after - before) / 2;
+}
+
+
+/** \brief Compute the rate of the TSC since the origin.
+ *
+ * \param[in] tsc  A TSC value read along \p raw_ns.
+ * \param[in] raw_ns  The CLOCK_MONOTONIC_RAW time in nanoseconds.
+ *
+ * \return The number of nanoseconds per tick or 0.0 if the TSC did not
+ * move forward.
+ */
+double ns_per_tick(std::uint64_t tsc, std::int64_t raw_ns)
+{
+    if(tsc <= g_origin.f_tsc
+    || raw_ns <= g_origin.f_raw_ns)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(raw_ns - g_origin.f_raw_ns)
+         / static_cast<double>(tsc - g_origin.f_tsc);
+}
+
+
+/** \brief Anchor the TSC to the realtime clock.
+ *
+ * The rate gets measured again against CLOCK_MONOTONIC_RAW from the
+ * origin, then the current TSC gets paired with CLOCK_REALTIME and the
+ * new anchor gets published.
+ *
+ * \param[in] rate  The rate to use if it cannot be measured again.
+ */
+void anchor(double rate)
+{
+    std::uint64_t tsc(0);
+    std::int64_t raw_ns(0);
+    read_pair(CLOCK_MONOTONIC_RAW, tsc, raw_ns);
+    double const measured(ns_per_tick(tsc, raw_ns));
+    if(measured > 0.0)
+    {
+        rate = measured;
+    }
+
+    std::shared_ptr<tsc_anchor> a(std::make_shared<tsc_anchor>());
+    read_pair(CLOCK_REALTIME, a->f_tsc, a->f_ns);
+    a->f_ns_per_tick = rate;
+    g_anchor.store(a);
+
+    g_next_anchor_tsc.store(
+              a->f_tsc + static_cast<std::uint64_t>(static_cast<double>(g_anchor_interval) / rate)
+            , std::memory_order_relaxed);
+}
+
+
+/** \brief Compute the number of nanoseconds per TSC tick.
+ *
+ * This function measures the TSC against CLOCK_MONOTONIC_RAW over 20ms.
+ * It only runs once, the first time the TSC clock gets selected. If the
+ * TSC does not move forward, the calibration fails and the realtime
+ * clock gets used instead.
+ */
+void calibrate()
+{
+    read_pair(CLOCK_MONOTONIC_RAW, g_origin.f_tsc, g_origin.f_raw_ns);
+
+    timespec const pause{ 0, 20'000'000 };
+    nanosleep(&pause, nullptr);
+
+    std::uint64_t tsc(0);
+    std::int64_t raw_ns(0);
+    read_pair(CLOCK_MONOTONIC_RAW, tsc, raw_ns);
+    double const rate(ns_per_tick(tsc, raw_ns));
+    if(rate <= 0.0)
+    {
+        return;
+    }
+
+    anchor(rate);
+    g_calibrated = true;
+}
+
+
+
+}
+// no name namespace
+
+
+
+namespace detail
+{
+
+
+
+std::atomic<clock_source_t>     g_clock_source = clock_source_t::CLOCK_SOURCE_COARSE;
+
+
+std::uint64_t read_tsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+
+/** \brief Convert a TSC value to a timespec.
+ *
+ * The conversion uses the latest anchor. When that anchor is more than
+ * about one second old, the first thread to notice anchors the TSC
+ * again. The other threads keep using the previous anchor meanwhile.
+ *
+ * The result is never earlier than the last timestamp returned by this
+ * function unless the difference is larger than g_maximum_backward_step
+ * (1ms). This way the timestamps do not go back when the TSC gets
+ * anchored again.
+ *
+ * \param[in] tsc  A value returned by read_tsc().
+ *
+ * \return The corresponding realtime timestamp.
+ */
+timespec tsc_to_timespec(std::uint64_t tsc)
+{
+    std::uint64_t next(g_next_anchor_tsc.load(std::memory_order_relaxed));
+    if(read_tsc() >= next
+    && g_next_anchor_tsc.compare_exchange_strong(next, std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed))
+    {
+        anchor(g_anchor.load()->f_ns_per_tick);
+    }
+
+    tsc_anchor::pointer_t const a(g_anchor.load());
+    std::int64_t const delta(static_cast<std::int64_t>(tsc - a->f_tsc));
+    std::int64_t ns(a->f_ns
+                  + static_cast<std::int64_t>(static_cast<double>(delta) * a->f_ns_per_tick));
+
+    // save the new timestamp as the last one unless it is slightly
+    // earlier, in which case we return the last one instead
+    //
+    std::int64_t last(g_last_ns.load(std::memory_order_relaxed));
+    for(;;)
+    {
+        if(ns <= last
+        && last - ns <= g_maximum_backward_step)
+        {
+            ns = last;
+            break;
+        }
+        if(g_last_ns.compare_exchange_weak(last, ns, std::memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    timespec result;
+    result.tv_sec = ns / g_nanoseconds_per_second;
+    result.tv_nsec = ns % g_nanoseconds_per_second;
+    return result;
+}
+
+
+
+}
+// detail namespace
+
+
+
+/** \brief Check whether the CPU has an invariant TSC.
+ *
+ * An invariant TSC runs at a constant rate in all the ACPI P-, C-, and
+ * T-states and is synchronized between cores, which makes it usable
+ * as a clock.
+ *
+ * \return true if the TSC clock source can be used.
+ */
+bool is_invariant_tsc_available()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax(0);
+    unsigned int ebx(0);
+    unsigned int ecx(0);
+    unsigned int edx(0);
+    if(__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0
+    || eax < 0x80000007)
+    {
+        return false;
+    }
+    if(__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0)
+    {
+        return false;
+    }
+    return (edx & (1U << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+
+/** \brief Select the clock used to timestamp new messages.
+ *
+ * If the TSC clock is requested but the CPU does not have an invariant
+ * TSC or its calibration fails, the realtime clock is used instead.
+ *
+ * \param[in] source  The requested clock source.
+ *
+ * \return The clock source actually in use.
+ */
+clock_source_t set_clock_source(clock_source_t source)
+{
+    if(source == clock_source_t::CLOCK_SOURCE_TSC)
+    {
+        if(is_invariant_tsc_available())
+        {
+            std::call_once(g_calibrate_once, calibrate);
+        }
+        if(!g_calibrated)
+        {
+            source = clock_source_t::CLOCK_SOURCE_REALTIME;
+        }
+    }
+
+    // release so the calibration is visible to threads using the TSC
+    //
+    detail::g_clock_source.store(source, std::memory_order_release);
+    return source;
+}
+
+
+clock_source_t get_clock_source()
+{
+    return detail::g_clock_source.load(std::memory_order_relaxed);
+}
+
+
+/** \brief Convert a clock source name.
+ *
+ * The supported names are "coarse", "realtime", and "tsc".
+ *
+ * \param[in] name  The name of the clock source.
+ * \param[out] source  The corresponding clock source.
+ *
+ * \return true if the name was recognized.
+ */
+bool clock_source_from_name(std::string const & name, clock_source_t & source)
+{
+    if(name == "coarse")
+    {
+        source = clock_source_t::CLOCK_SOURCE_COARSE;
+        return true;
+    }
+    if(name == "realtime")
+    {
+        source = clock_source_t::CLOCK_SOURCE_REALTIME;
+        return true;
+    }
+    if(name == "tsc")
+    {
+        source = clock_source_t::CLOCK_SOURCE_TSC;
+        return true;
+    }
+    return false;
+}
+
+
+
+} // snaplogger namespace
+// vim: ts=4 sw=4 et
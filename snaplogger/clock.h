@@ -0,0 +1,76 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/snaplogger
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+/** \file
+ * \brief Select the clock used to timestamp messages.
+ *
+ * By default, messages are timestamped with CLOCK_REALTIME_COARSE which
+ * is fast but only has a precision of a few milliseconds. The realtime
+ * clock is precise but costs a full clock_gettime() call. The TSC clock
+ * reads the CPU time stamp counter and converts it to a time only when
+ * the message gets formatted. It is only available on CPUs with an
+ * invariant TSC.
+ */
+
+
+// C++
+//
+#include    <atomic>
+#include    <cstdint>
+#include    <string>
+
+
+// C
+//
+#include    <time.h>
+
+
+
+namespace snaplogger
+{
+
+
+
+enum class clock_source_t
+{
+    CLOCK_SOURCE_COARSE,
+    CLOCK_SOURCE_REALTIME,
+    CLOCK_SOURCE_TSC,
+};
+
+
+bool                    is_invariant_tsc_available();
+clock_source_t          set_clock_source(clock_source_t source);
+clock_source_t          get_clock_source();
+bool                    clock_source_from_name(std::string const & name, clock_source_t & source);
+
+
+namespace detail
+{
+extern std::atomic<clock_source_t>  g_clock_source;
+
+std::uint64_t           read_tsc();
+timespec                tsc_to_timespec(std::uint64_t tsc);
+}
+// detail namespace
+
+
+
+} // snaplogger namespace
+// vim: ts=4 sw=4 et
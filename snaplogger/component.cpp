@@ -73,9 +73,11 @@ component::pointer_t        g_not_implemented_component(get_component(COMPONENT_
  * The get_component() functions make sure that won't happen.
  *
  * \param[in] name  The name of the new component.
+ * \param[in] index  The index of the new component.
  */
-component::component(std::string const & name)
+component::component(std::string const & name, std::size_t index)
     : f_name(name)
+    , f_index(index)
 {
 }
 
@@ -86,46 +88,48 @@ std::string const & component::get_name() const
 }
 
 
+/** \brief Get the index of this component.
+ *
+ * Each component is given a unique index when created. The first
+ * component is given index 0, the next 1, etc. The index is used to
+ * quickly find the appenders which accept a message with this component.
+ *
+ * \return The index of this component.
+ */
+std::size_t component::get_index() const
+{
+    return f_index;
+}
+
+
 void component::add_mutually_exclusive_components(set_t components)
 {
-    f_mutually_exclusive_components.insert(components.begin(), components.end());
+    f_mutually_exclusive_components |= to_component_mask(components);
 }
 
 
 bool component::is_mutually_exclusive(pointer_t other_component) const
 {
-    return f_mutually_exclusive_components.find(other_component) != f_mutually_exclusive_components.end();
+    return f_mutually_exclusive_components.test(other_component->get_index());
 }
 
 
 bool component::is_mutually_exclusive(set_t const & other_components) const
 {
-    // IMPORTNAT NOTE: the sets are sorted by pointers, not names (it
-    //                 makes them a lot faster!) so this code compares
-    //                 the pointers
-    //
-    auto mc(f_mutually_exclusive_components.begin());
-    auto me(f_mutually_exclusive_components.end());
-    auto oc(other_components.begin());
-    auto oe(other_components.end());
-    while(mc != me && oc != oe)
-    {
-        std::intptr_t const c(mc->get() - oc->get());
-        if(c < 0)
-        {
-            ++mc;
-        }
-        else if(c > 0)
-        {
-            ++oc;
-        }
-        else
-        {
-            return true;
-        }
-    }
+    return is_mutually_exclusive(to_component_mask(other_components));
+}
 
-    return false;
+
+/** \brief Check whether one of the components is mutually exclusive.
+ *
+ * \param[in] other_components  The mask of the components to check.
+ *
+ * \return true if at least one of the components in \p other_components
+ * is mutually exclusive with this component.
+ */
+bool component::is_mutually_exclusive(mask_t const & other_components) const
+{
+    return (f_mutually_exclusive_components & other_components).any();
 }
 
 
@@ -166,5 +170,59 @@ component::pointer_t get_component(message const & msg, std::string const & name
 }
 
 
+/** \brief Get a component from its index.
+ *
+ * \param[in] index  The index of the component as returned by
+ * component::get_index().
+ *
+ * \return The component or a null pointer if \p index is not the index
+ * of an existing component.
+ */
+component::pointer_t get_component_by_index(std::size_t index)
+{
+    return get_private_logger()->get_component_by_index(index);
+}
+
+
+/** \brief Convert a set of components to a mask.
+ *
+ * \param[in] components  The set of components to convert.
+ *
+ * \return A mask with the bit of each component in \p components set.
+ */
+component::mask_t to_component_mask(component::set_t const & components)
+{
+    component::mask_t mask;
+    for(auto const & c : components)
+    {
+        mask.set(c->get_index());
+    }
+    return mask;
+}
+
+
+/** \brief Convert a mask of components back to a set.
+ *
+ * This function is used to offer the older set based interface. It is
+ * not expected to be used while processing messages.
+ *
+ * \param[in] mask  The mask of components to convert.
+ *
+ * \return The set of components found in \p mask.
+ */
+component::set_t to_component_set(component::mask_t const & mask)
+{
+    component::set_t components;
+    for(std::size_t idx(0); idx < mask.size(); ++idx)
+    {
+        if(mask.test(idx))
+        {
+            components.insert(get_component_by_index(idx));
+        }
+    }
+    return components;
+}
+
+
 } // snaplogger namespace
 // vim: ts=4 sw=4 et
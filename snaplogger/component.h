@@ -56,11 +56,18 @@
  * To create a component, you have to use one of the get_component()
  * functions. One includes a message which means we have a direct access
  * to the private logger object.
+ *
+ * Each component is given a small index when created. Messages, appenders
+ * and the logger keep their components in a bitset (a component::mask_t)
+ * where bit N represents the component with index N. Checking whether a
+ * message has a component or whether it shares a component with an
+ * appender is then a matter of a few bitwise operations.
  */
 
 
 // C++
 //
+#include    <bitset>
 #include    <map>
 #include    <memory>
 #include    <set>
@@ -84,19 +91,26 @@ public:
     typedef std::map<std::string, pointer_t>    map_t;
     typedef std::set<pointer_t>                 set_t;
 
+    static constexpr std::size_t    MAX_COMPONENTS = 256;
+
+    typedef std::bitset<MAX_COMPONENTS>         mask_t;
+
     std::string const &         get_name() const;
+    std::size_t                 get_index() const;
 
     void                        add_mutually_exclusive_components(set_t components);
     bool                        is_mutually_exclusive(pointer_t other_component) const;
     bool                        is_mutually_exclusive(set_t const & other_component) const;
+    bool                        is_mutually_exclusive(mask_t const & other_components) const;
 
 private:
     friend private_logger;
 
-                                component(std::string const & name);
+                                component(std::string const & name, std::size_t index);
 
     std::string const           f_name;
-    set_t                       f_mutually_exclusive_components = {};
+    std::size_t const           f_index;
+    mask_t                      f_mutually_exclusive_components = mask_t();
 };
 
 
@@ -104,6 +118,9 @@ private:
 component::pointer_t            get_component(std::string const & name);
 component::pointer_t            get_component(std::string const & name, component::set_t mutually_exclusive);
 component::pointer_t            get_component(message const & msg, std::string const & name);
+component::pointer_t            get_component_by_index(std::size_t index);
+component::mask_t               to_component_mask(component::set_t const & components);
+component::set_t                to_component_set(component::mask_t const & mask);
 
 
 constexpr char const            COMPONENT_AS2JS[]           = "as2js";
@@ -30,8 +30,6 @@
 //
 #include    "snaplogger/console_appender.h"
 
-#include    "snaplogger/guard.h"
-
 
 // snapdev
 //
@@ -42,6 +40,7 @@
 // C++
 //
 #include    <iostream>
+#include    <map>
 #include    <set>
 
 
@@ -193,6 +192,87 @@ name_to_style const       g_name_to_style[] =
 
 
 
+/** \brief Convert a list of styles to ANSI sequences.
+ *
+ * The \p styles parameter is a comma separated list of style names such
+ * as "bold,red". Each style belongs to a group (i.e. the foreground
+ * color). When several styles of the same group are listed, the last one
+ * wins. A style such as "underline-off" removes its group.
+ *
+ * The severity table calls this function once per severity so the
+ * console appender does not have to parse the styles of each message.
+ *
+ * \param[in] styles  The list of styles to convert.
+ * \param[out] style  The sequence to output before the message.
+ * \param[out] unstyle  The sequence to output after the message.
+ */
+void styles_to_ansi(std::string const & styles, std::string & style, std::string & unstyle)
+{
+    style.clear();
+    unstyle.clear();
+
+    advgetopt::string_list_t names;
+    advgetopt::split_string(styles, names, {","});
+    if(names.empty())
+    {
+        return;
+    }
+
+    struct in_out_t
+    {
+        char const *    f_style;
+        char const *    f_unstyle;
+    };
+    typedef std::map<group_t, in_out_t>  map_t;
+
+    map_t processed_styles;
+    for(auto const & s : names)
+    {
+        int i(0);
+        int j(sizeof(g_name_to_style) / sizeof(g_name_to_style[0]));
+        while(i < j)
+        {
+            int const p(i + (j - i) / 2);
+            int const r(s.compare(g_name_to_style[p].f_name));
+            if(r == 0)
+            {
+                if(g_name_to_style[p].f_style != nullptr)
+                {
+                    processed_styles[g_name_to_style[p].f_group].f_style = g_name_to_style[p].f_style;
+                    processed_styles[g_name_to_style[p].f_group].f_unstyle = g_name_to_style[p].f_unstyle;
+                }
+                else
+                {
+                    processed_styles.erase(g_name_to_style[p].f_group);
+                }
+                break;
+            }
+            if(r < 0)
+            {
+                j = p;
+            }
+            else // if(r > 0)
+            {
+                i = p + 1;
+            }
+        }
+    }
+
+    for(auto const & ps : processed_styles)
+    {
+        if(ps.second.f_style != nullptr)
+        {
+            style += ps.second.f_style;
+        }
+        if(ps.second.f_unstyle != nullptr)
+        {
+            unstyle += ps.second.f_unstyle;
+        }
+    }
+}
+
+
+
 console_appender::console_appender(std::string const name)
     : appender(name, "console")
 {
@@ -276,8 +356,6 @@ std::string const & console_appender::get_output_stream() const
 
 bool console_appender::process_message(message const & msg, std::string const & formatted_message)
 {
-    guard g;
-
     if(!f_initialized)
     {
         f_initialized = true;
@@ -320,93 +398,26 @@ bool console_appender::process_message(message const & msg, std::string const &
         lock_file = std::make_unique<snapdev::lockfd>(f_fd, snapdev::operation_t::OPERATION_EXCLUSIVE);
     }
 
-    std::string style;
-    std::string unstyle;
+    // the table keeps the sequences alive while we write them
+    //
+    std::string_view style;
+    std::string_view unstyle;
+    severity_table_pointer_t table;
     if(f_is_a_tty || f_force_style)
     {
-        severity::pointer_t const sev(snaplogger::get_severity(msg, msg.get_severity()));
-        if(sev != nullptr)
-        {
-            advgetopt::string_list_t styles;
-            advgetopt::split_string(sev->get_styles(), styles, {","});
-            if(!styles.empty())
-            {
-                struct in_out_t
-                {
-                    char const *    f_style;
-                    char const *    f_unstyle;
-                };
-                typedef std::map<group_t, in_out_t>  map_t;
-
-                map_t processed_styles;
-                //std::set<std::string> style_set;
-                //std::set<std::string> unstyle_set;
-                for(auto s : styles)
-                {
-                    int i(0);
-                    int j(sizeof(g_name_to_style) / sizeof(g_name_to_style[0]));
-                    while(i < j)
-                    {
-                        int const p(i + (j - i) / 2);
-                        int const r(s.compare(g_name_to_style[p].f_name));
-                        if(r == 0)
-                        {
-                            auto it(processed_styles.find(g_name_to_style[p].f_group));
-                            if(g_name_to_style[p].f_style != nullptr)
-                            {
-                                processed_styles[g_name_to_style[p].f_group].f_style = g_name_to_style[p].f_style;
-                                processed_styles[g_name_to_style[p].f_group].f_unstyle = g_name_to_style[p].f_unstyle;
-                            }
-                            else if(it != processed_styles.end())
-                            {
-                                processed_styles.erase(it);
-                            }
-                            //style_set.insert(g_name_to_style[p].f_style);
-                            //unstyle_set.insert(g_name_to_style[p].f_unstyle);
-                            break;
-                        }
-                        if(r < 0)
-                        {
-                            j = p;
-                        }
-                        else // if(r > 0)
-                        {
-                            i = p + 1;
-                        }
-                    }
-                }
-                if(!processed_styles.empty())
-                {
-                    for(auto const & ps : processed_styles)
-                    {
-                        if(ps.second.f_style != nullptr)
-                        {
-                            style += ps.second.f_style;
-                        }
-                        if(ps.second.f_unstyle != nullptr)
-                        {
-                            unstyle += ps.second.f_unstyle;
-                        }
-                    }
-                    //processed_styles[g_name_to_style[p].f_group].f_style = g_name_to_style[p].f_style;
-                    //processed_styles[g_name_to_style[p].f_group].f_unstyle = g_name_to_style[p].f_unstyle;
-                    //style = snapdev::join_strings(style_set, std::string());
-                }
-                //if(!unstyle_set.empty())
-                //{
-                //    unstyle = snapdev::join_strings(unstyle_set, std::string());
-                //}
-            }
-        }
+        table = get_severity_table(msg);
+        severity_entry const & entry((*table)[static_cast<std::size_t>(msg.get_severity())]);
+        style = entry.f_ansi_style;
+        unstyle = entry.f_ansi_unstyle;
     }
 
-    ssize_t const l1(write(f_fd, style.c_str(), style.length()));
+    ssize_t const l1(write(f_fd, style.data(), style.length()));
     if(static_cast<size_t>(l1) == style.length())
     {
         ssize_t const l2(write(f_fd, formatted_message.c_str(), formatted_message.length()));
         if(static_cast<size_t>(l2) == formatted_message.length())
         {
-            ssize_t const l3(write(f_fd, unstyle.c_str(), unstyle.length()));
+            ssize_t const l3(write(f_fd, unstyle.data(), unstyle.length()));
             if(static_cast<size_t>(l3) == unstyle.length())
             {
                 return true;
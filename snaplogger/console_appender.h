@@ -72,5 +72,8 @@ private:
 };
 
 
+void                        styles_to_ansi(std::string const & styles, std::string & style, std::string & unstyle);
+
+
 } // snaplogger namespace
 // vim: ts=4 sw=4 et
@@ -76,293 +76,389 @@ timespec const g_start_date = []() { timespec tp; clock_gettime(CLOCK_REALTIME_C
 
 
 
-DEFINE_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(date)
+/** \brief The decoded parameters of a date, time, or locale variable.
+ *
+ * The first parameter of these variables selects what gets output. It
+ * is decoded once, when the format gets parsed, to either a strftime()
+ * pattern or one of the parts which strftime() does not support.
+ */
+struct date_plan
+{
+    enum class part_t
+    {
+        PART_STRFTIME,
+        PART_DAY_OF_WEEK_NAME,
+        PART_MONTH_NAME,
+        PART_MILLISECOND,
+        PART_MICROSECOND,
+        PART_NANOSECOND,
+        PART_UNIX,
+        PART_OFFSET,
+        PART_PROCESS,
+        PART_THREAD,
+        PART_PROCESS_MS,
+        PART_THREAD_MS,
+    };
+
+    part_t              f_part = part_t::PART_STRFTIME;
+    std::string         f_format = std::string();
+    bool                f_leading_zeroes = false;
+};
+
+
+bool is_leading_zeroes(param::pointer_t const & p)
+{
+    return p->get_type() == param::type_t::TYPE_STRING
+        && (p->get_value() == "leadingzeroes"
+            || p->get_value() == "leadingzeros");
+}
+
+
+void append_strftime(std::string & value, std::string const & format, tm const & t)
+{
+    char buf[256];
+    strftime(buf, sizeof(buf), format.c_str(), &t);
+    buf[sizeof(buf) - 1] = '\0';
+    value += buf;
+}
+
+
+std::string nanosec(timespec const & tp)
+{
+    std::string const sec(std::to_string(tp.tv_sec));
+    std::string nsec(std::to_string(tp.tv_nsec));
+    if(nsec.length() < 9)
+    {
+        nsec = std::string("000000000").substr(0, 9 - nsec.length()) + nsec;
+    }
+    return sec + nsec;
+}
+
+
+std::string cpu_ms(timespec const & tp)
+{
+    std::string ms(std::to_string(tp.tv_nsec / 1'000'000UL));
+    if(ms.length() < 3)
+    {
+        ms = std::string("000").substr(0, 3 - ms.length()) + ms;
+    }
+    return ms;
+}
+
+
+std::string fraction(long value, std::size_t digits, bool leading_zeroes)
+{
+    std::string result(std::to_string(value));
+    if(leading_zeroes
+    && result.length() < digits)
+    {
+        result = std::string(digits - result.length(), '0') + result;
+    }
+    return result;
+}
+
+
+
+
+
+DEFINE_COMPILED_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(date, date_plan)
 {
     tm t;
     timespec const & timestamp(msg.get_timestamp());
     gmtime_r(&timestamp.tv_sec, &t);
 
-    std::string date_format("%Y/%m/%d");
-    auto params(get_params());
+    switch(f_plan.f_part)
+    {
+    case date_plan::part_t::PART_DAY_OF_WEEK_NAME:
+        value += g_day_name[t.tm_wday];
+        break;
+
+    case date_plan::part_t::PART_MONTH_NAME:
+        value += g_month_name[t.tm_mon];
+        break;
+
+    default:
+        {
+            char buf[256];
+            strftime(buf, sizeof(buf), f_plan.f_format.c_str(), &t);
+            buf[sizeof(buf) - 1] = '\0';
+            if(buf[0] == '0')
+            {
+                int n(0);
+                for(; buf[n] == '0'; ++n);
+                if(buf[n] == '\0')
+                {
+                    // keep at least one zero
+                    //
+                    value += '0';
+                }
+                else
+                {
+                    value += buf + n;
+                }
+            }
+            else
+            {
+                value += buf;
+            }
+        }
+        break;
+
+    }
+
+    variable::process_value(msg, value);
+}
+
+
+COMPILE_LOGGER_VARIABLE(date)
+{
+    f_plan.f_format = "%Y/%m/%d";
+
+    auto const & params(get_params());
     if(!params.empty())
     {
-        auto const p(params[0]->get_name());
+        auto const & p(params[0]->get_name());
         if(p == "day")
         {
-            date_format = "%d";
+            f_plan.f_format = "%d";
         }
         else if(p == "day_of_week_name")
         {
-            value += g_day_name[t.tm_wday];
-            date_format.clear();
+            f_plan.f_part = date_plan::part_t::PART_DAY_OF_WEEK_NAME;
         }
         else if(p == "day_of_week")
         {
-            date_format = "%w"; // TBD: people may want %u though...
+            f_plan.f_format = "%w"; // TBD: people may want %u though...
         }
         else if(p == "year_week")
         {
-            date_format = "%U"; // TBD: people may want %V or %W though...
+            f_plan.f_format = "%U"; // TBD: people may want %V or %W though...
         }
         else if(p == "year_day")
         {
-            date_format = "%j";
+            f_plan.f_format = "%j";
         }
         else if(p == "month_name")
         {
-            value += g_month_name[t.tm_mon];
-            date_format.clear();
+            f_plan.f_part = date_plan::part_t::PART_MONTH_NAME;
         }
         else if(p == "month")
         {
-            date_format = "%m";
+            f_plan.f_format = "%m";
         }
         else if(p == "year")
         {
-            date_format = "%Y";
+            f_plan.f_format = "%Y";
         }
         else
         {
             throw invalid_variable("the ${date:...} variable first parameter must be its name parameter.");
         }
     }
+}
 
-    if(!date_format.empty())
+
+DEFINE_COMPILED_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(time, date_plan)
+{
+    tm t;
+    timespec timestamp(msg.get_timestamp());
+    gmtime_r(&timestamp.tv_sec, &t);
+
+    switch(f_plan.f_part)
     {
-        char buf[256];
-        strftime(buf, sizeof(buf), date_format.c_str(), &t);
-        buf[sizeof(buf) - 1] = '\0';
-        if(buf[0] == '0')
-        {
-            int n(0);
-            for(; buf[n] == '0'; ++n);
-            if(buf[n] == '\0')
-            {
-                // keep at least one zero
-                //
-                value += '0';
-            }
-            else
+    case date_plan::part_t::PART_MILLISECOND:
+        value += fraction(timestamp.tv_nsec / 1'000'000LL, 3, f_plan.f_leading_zeroes);
+        break;
+
+    case date_plan::part_t::PART_MICROSECOND:
+        value += fraction(timestamp.tv_nsec / 1'000LL, 6, f_plan.f_leading_zeroes);
+        break;
+
+    case date_plan::part_t::PART_NANOSECOND:
+        value += fraction(timestamp.tv_nsec, 9, f_plan.f_leading_zeroes);
+        break;
+
+    case date_plan::part_t::PART_UNIX:
+        value += std::to_string(timestamp.tv_sec);
+        break;
+
+    case date_plan::part_t::PART_OFFSET:
+        {
+            timespec offset;
+            offset.tv_nsec = timestamp.tv_nsec - g_start_date.tv_nsec;
+            offset.tv_sec = timestamp.tv_sec - g_start_date.tv_sec;
+            if(offset.tv_nsec < 0)
             {
-                value += buf + n;
+                --offset.tv_sec;
+                offset.tv_nsec += 1000000000;
             }
+            value += nanosec(offset);
         }
-        else
-        {
-            value += buf;
-        }
+        break;
+
+    case date_plan::part_t::PART_PROCESS:
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &timestamp);
+        value += nanosec(timestamp);
+        break;
+
+    case date_plan::part_t::PART_THREAD:
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &timestamp);
+        value += nanosec(timestamp);
+        break;
+
+    case date_plan::part_t::PART_PROCESS_MS:
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &timestamp);
+        gmtime_r(&timestamp.tv_sec, &t);
+        append_strftime(value, f_plan.f_format + "." + cpu_ms(timestamp), t);
+        break;
+
+    case date_plan::part_t::PART_THREAD_MS:
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &timestamp);
+        gmtime_r(&timestamp.tv_sec, &t);
+        append_strftime(value, f_plan.f_format + "." + cpu_ms(timestamp), t);
+        break;
+
+    default:
+        append_strftime(value, f_plan.f_format, t);
+        break;
+
     }
 
     variable::process_value(msg, value);
 }
 
 
-DEFINE_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(time)
+COMPILE_LOGGER_VARIABLE(time)
 {
-    auto nanosec = [](timespec const & tp)
-    {
-        std::string const sec(std::to_string(tp.tv_sec));
-        std::string nsec(std::to_string(tp.tv_nsec));
-        if(nsec.length() < 9)
-        {
-            nsec = std::string("000000000").substr(0, 9 - nsec.length()) + nsec;
-        }
-        return sec + nsec;
-    };
-
-    tm t;
-    timespec timestamp(msg.get_timestamp());
-    gmtime_r(&timestamp.tv_sec, &t);
+    f_plan.f_format = "%H:%M:%S";
 
-    std::string time_format("%H:%M:%S");
-    auto params(get_params());
+    auto const & params(get_params());
     if(!params.empty())
     {
-        auto const p(params[0]->get_name());
+        auto const & p(params[0]->get_name());
+        f_plan.f_leading_zeroes = is_leading_zeroes(params[0]);
         if(p == "hour")
         {
-            if(params[0]->get_value() == "12")
+            bool const twelve(params[0]->get_type() == param::type_t::TYPE_INTEGER
+                                ? params[0]->get_integer() == 12
+                                : params[0]->get_value() == "12");
+            if(twelve)
             {
-                time_format = "%I";
+                f_plan.f_format = "%I";
             }
             else
             {
-                time_format = "%H";
+                f_plan.f_format = "%H";
             }
         }
         else if(p == "minute")
         {
-            time_format = "%M"; // TBD: people may want %u though...
+            f_plan.f_format = "%M"; // TBD: people may want %u though...
         }
         else if(p == "second")
         {
-            time_format = "%S"; // TBD: people may want %V or %W though...
+            f_plan.f_format = "%S"; // TBD: people may want %V or %W though...
         }
         else if(p == "millisecond")
         {
-            std::string msec(std::to_string(timestamp.tv_nsec / 1000000LL));
-            if(msec.length() < 3
-            && (params[0]->get_value() == "leadingzeroes"
-                || params[0]->get_value() == "leadingzeros"))
-            {
-                msec = std::string("000").substr(0, 3  - msec.length()) + msec;
-            }
-            value += msec;
-            time_format.clear();
+            f_plan.f_part = date_plan::part_t::PART_MILLISECOND;
         }
         else if(p == "microsecond")
         {
-            std::string usec(std::to_string(timestamp.tv_nsec / 1000LL));
-            if(usec.length() < 6
-            && (params[0]->get_value() == "leadingzeroes"
-                || params[0]->get_value() == "leadingzeros"))
-            {
-                usec = std::string("000000").substr(0, 6  - usec.length()) + usec;
-            }
-            value += usec;
-            time_format.clear();
+            f_plan.f_part = date_plan::part_t::PART_MICROSECOND;
         }
         else if(p == "nanosecond")
         {
-            std::string nsec(std::to_string(timestamp.tv_nsec));
-            if(nsec.length() < 9
-            && (params[0]->get_value() == "leadingzeroes"
-                || params[0]->get_value() == "leadingzeros"))
-            {
-                nsec = std::string("000000000").substr(0, 9  - nsec.length()) + nsec;
-            }
-            value += nsec;
-            time_format.clear();
+            f_plan.f_part = date_plan::part_t::PART_NANOSECOND;
         }
         else if(p == "unix")
         {
-            value += std::to_string(timestamp.tv_sec);
-            time_format.clear();
+            f_plan.f_part = date_plan::part_t::PART_UNIX;
         }
         else if(p == "meridiem")
         {
             // TODO: we should force English here (AM or PM)
             //
-            time_format = "%p";
+            f_plan.f_format = "%p";
         }
         else if(p == "offset")
         {
-            timespec offset;
-            offset.tv_nsec = timestamp.tv_nsec - g_start_date.tv_nsec;
-            offset.tv_sec = timestamp.tv_sec - g_start_date.tv_sec;
-            if(offset.tv_nsec < 0)
-            {
-                --offset.tv_sec;
-                offset.tv_nsec += 1000000000;
-            }
-            value += nanosec(offset);
-            time_format.clear();
+            f_plan.f_part = date_plan::part_t::PART_OFFSET;
         }
         else if(p == "process")
         {
-            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &timestamp);
-            value += nanosec(timestamp);
-            time_format.clear();
+            f_plan.f_part = date_plan::part_t::PART_PROCESS;
         }
         else if(p == "thread")
         {
-            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &timestamp);
-            value += nanosec(timestamp);
-            time_format.clear();
+            f_plan.f_part = date_plan::part_t::PART_THREAD;
         }
         else if(p == "process_ms")
         {
-            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &timestamp);
-            gmtime_r(&timestamp.tv_sec, &t);
-            std::string ms(std::to_string(timestamp.tv_nsec / 1'000'000UL));
-            if(ms.length() < 3)
-            {
-                ms = std::string("000").substr(0, 3 - ms.length()) + ms;
-            }
-            time_format += ".";
-            time_format += ms;
+            f_plan.f_part = date_plan::part_t::PART_PROCESS_MS;
         }
         else if(p == "thread_ms")
         {
-            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &timestamp);
-            gmtime_r(&timestamp.tv_sec, &t);
-            std::string ms(std::to_string(timestamp.tv_nsec / 1000000UL));
-            if(ms.length() < 3)
-            {
-                ms = std::string("000").substr(0, 3 - ms.length()) + ms;
-            }
-            time_format += ".";
-            time_format += ms;
+            f_plan.f_part = date_plan::part_t::PART_THREAD_MS;
         }
         else
         {
             throw invalid_variable("the ${time:...} variable first parameter must be its name parameter.");
         }
     }
-
-    if(!time_format.empty())
-    {
-        char buf[256];
-        strftime(buf, sizeof(buf), time_format.c_str(), &t);
-        buf[sizeof(buf) - 1] = '\0';
-        value += buf;
-    }
-
-    variable::process_value(msg, value);
 }
 
 
-DEFINE_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(locale)
+DEFINE_COMPILED_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(locale, date_plan)
 {
     tm t;
     timespec const & timestamp(msg.get_timestamp());
     localtime_r(&timestamp.tv_sec, &t);
 
-    std::string locale_format("%c");
-    auto params(get_params());
+    append_strftime(value, f_plan.f_format, t);
+
+    variable::process_value(msg, value);
+}
+
+
+COMPILE_LOGGER_VARIABLE(locale)
+{
+    f_plan.f_format = "%c";
+
+    auto const & params(get_params());
     if(!params.empty())
     {
-        auto const p(params[0]->get_name());
+        auto const & p(params[0]->get_name());
         if(p == "day_of_week_name")
         {
-            locale_format = "%A";   // TBD: support %a as well
+            f_plan.f_format = "%A";   // TBD: support %a as well
         }
         else if(p == "month_name")
         {
-            locale_format = "%B";     // TBD: support %b as well
+            f_plan.f_format = "%B";     // TBD: support %b as well
         }
         else if(p == "date")
         {
-            locale_format = "%x";
+            f_plan.f_format = "%x";
         }
         else if(p == "time")
         {
-            locale_format = "%X";
+            f_plan.f_format = "%X";
         }
         else if(p == "meridiem")
         {
-            locale_format = "%p";
+            f_plan.f_format = "%p";
         }
         else if(p == "timezone")
         {
-            locale_format = "%Z";
+            f_plan.f_format = "%Z";
         }
         else if(p == "timezone_offset")
         {
-            locale_format = "%z";
+            f_plan.f_format = "%z";
         }
         // else -- assume params are system parameters
     }
-
-    if(!locale_format.empty())
-    {
-        char buf[256];
-        strftime(buf, sizeof(buf), locale_format.c_str(), &t);
-        buf[sizeof(buf) - 1] = '\0';
-        value += buf;
-    }
-
-    variable::process_value(msg, value);
 }
 
 
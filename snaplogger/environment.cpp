@@ -41,7 +41,6 @@
 //
 #include    "snaplogger/environment.h"
 
-#include    "snaplogger/guard.h"
 #include    "snaplogger/map_diagnostic.h"
 #include    "snaplogger/private_logger.h"
 
@@ -51,6 +50,11 @@
 #include    <cppthread/thread.h>
 
 
+// C++
+//
+#include    <atomic>
+
+
 // C
 //
 #include    <grp.h>
@@ -72,59 +76,192 @@ namespace snaplogger
 
 
 
-environment::environment(pid_t tid)
-    : f_tid(tid)
+namespace
 {
-    f_uid = getuid();
-    f_pid = getpid();
-    f_gid = getgid();
+
+
+
+/** \brief A name along the identifier it was resolved from.
+ *
+ * The user and group names are resolved from the UID and GID. We keep
+ * the identifier so we can verify that the cached name still corresponds
+ * to the environment identifier (i.e. after a setuid() call, the
+ * environment of new threads gets a different UID).
+ */
+struct id_name
+{
+    id_t                f_id = static_cast<id_t>(-1);
+    std::string         f_name = std::string();
+};
+
+
+/** \brief A process wide value resolved on first use.
+ *
+ * Values such as the user name or the host name are the same for all the
+ * threads of a process and they can be slow to retrieve (i.e. NSS may
+ * have to query an LDAP server). This class calls the resolver function
+ * the first time the value is requested and keeps the result until
+ * refresh_identity() gets called.
+ *
+ * Two threads may end up resolving the value simultaneously. Both get
+ * the same result so that is harmless and it avoids a lock on the
+ * fast path.
+ *
+ * The constructor is constexpr so the global lazy values are constant
+ * initialized (see the constinit below) and can safely be used by the
+ * constructors of other static objects.
+ */
+template<typename T>
+class lazy_value
+{
+public:
+    typedef std::shared_ptr<T const>        pointer_t;
+    typedef T (*resolver_t)();
+
+    constexpr lazy_value(resolver_t resolver)
+        : f_resolver(resolver)
+    {
+    }
+
+    pointer_t get()
+    {
+        pointer_t value(f_value.load());
+        if(value == nullptr)
+        {
+            value = std::make_shared<T const>(f_resolver());
+            f_value.store(value);
+        }
+        return value;
+    }
+
+    void reset()
+    {
+        f_value.store(pointer_t());
+    }
+
+private:
+    resolver_t                  f_resolver = nullptr;
+
+    // the std::atomic<std::shared_ptr<>> constructor taking a pointer is
+    // not constexpr, only its default constructor is
+    //
+    std::atomic<pointer_t>      f_value {};
+};
+
+
+id_name resolve_username(uid_t uid)
+{
+    id_name result;
+    result.f_id = uid;
 
     char buf[1024];
     passwd pw;
     passwd * pw_ptr(nullptr);
-    if(getpwuid_r(f_uid, &pw, buf, sizeof(buf), &pw_ptr) == 0
+    if(getpwuid_r(uid, &pw, buf, sizeof(buf), &pw_ptr) == 0
     && pw_ptr == &pw)
     {
-        f_username = pw.pw_name;
+        result.f_name = pw.pw_name;
     }
 
+    return result;
+}
+
+
+id_name resolve_groupname(gid_t gid)
+{
+    id_name result;
+    result.f_id = gid;
+
+    char buf[1024];
     group gr;
     group * gr_ptr(nullptr);
-    if(getgrgid_r(f_gid, &gr, buf, sizeof(buf), &gr_ptr) == 0
+    if(getgrgid_r(gid, &gr, buf, sizeof(buf), &gr_ptr) == 0
     && gr_ptr == &gr)
     {
-        f_groupname += gr.gr_name;
+        result.f_name = gr.gr_name;
     }
 
-    char host_buffer[HOST_NAME_MAX + 2];
-    host_buffer[HOST_NAME_MAX + 1] = '\0'; // make sure it's null terminated
+    return result;
+}
 
-    if(gethostname(host_buffer, HOST_NAME_MAX + 1) == 0)
+
+constinit lazy_value<id_name> g_username([]()
     {
-        f_hostname = host_buffer;
-    }
+        return resolve_username(getuid());
+    });
 
-    if(getdomainname(host_buffer, HOST_NAME_MAX + 1) == 0)
+
+constinit lazy_value<id_name> g_groupname([]()
     {
-        f_domainname = host_buffer;
-    }
+        return resolve_groupname(getgid());
+    });
 
-    map_diagnostics_t const diag(get_map_diagnostics());
 
-    auto const prog_it(diag.find("progname"));
-    if(prog_it != diag.end())
+constinit lazy_value<std::string> g_hostname([]()
     {
-        f_progname = prog_it->second;
-    }
+        char host_buffer[HOST_NAME_MAX + 2];
+        host_buffer[HOST_NAME_MAX + 1] = '\0'; // make sure it's null terminated
+        if(gethostname(host_buffer, HOST_NAME_MAX + 1) != 0)
+        {
+            return std::string();
+        }
+        return std::string(host_buffer);
+    });
 
-    std::string const tid_str(std::to_string(tid));
-    auto const thread_it(diag.find("threadname#" + tid_str));
-    if(thread_it != diag.end())
+
+constinit lazy_value<std::string> g_domainname([]()
     {
-        f_threadname = thread_it->second;
-    }
+        char domain_buffer[HOST_NAME_MAX + 2];
+        domain_buffer[HOST_NAME_MAX + 1] = '\0'; // make sure it's null terminated
+        if(getdomainname(domain_buffer, HOST_NAME_MAX + 1) != 0)
+        {
+            return std::string();
+        }
+        return std::string(domain_buffer);
+    });
+
+
+constinit lazy_value<std::string> g_boot_id([]()
+    {
+        return cppthread::get_boot_id();
+    });
+
+
 
-    f_boot_id = cppthread::get_boot_id();
+}
+// no name namespace
+
+
+
+/** \brief Initialize the environment of a thread.
+ *
+ * The environment only saves the few values which are specific to
+ * the thread or cheap to retrieve (UID, PID, GID, TID, and thread name).
+ *
+ * The user name, group name, host name, domain name, and boot identifier
+ * are the same for the entire process. They are resolved only if used,
+ * the first time one of the corresponding functions gets called, and
+ * then cached. Call refresh_identity() if any of these values changes
+ * (i.e. the computer was given a new hostname).
+ *
+ * The program name is read from the "progname" diagnostic when requested.
+ *
+ * The environment of a thread is cached and keeps the UID and GID it
+ * was created with. If the process changes its identity (i.e. a daemon
+ * dropping its privileges), the process wide user and group names do
+ * not match the environment anymore. In that case the environment
+ * resolves its own names once and keeps them.
+ *
+ * \param[in] tid  The identifier of the thread this environment represents.
+ */
+environment::environment(pid_t tid)
+    : f_tid(tid)
+{
+    f_uid = getuid();
+    f_pid = getpid();
+    f_gid = getgid();
+
+    f_threadname = get_diagnostic("threadname#" + std::to_string(tid));
 }
 
 
@@ -155,57 +292,69 @@ pid_t environment::get_tid() const
 
 std::string environment::get_username() const
 {
-    guard g;
+    lazy_value<id_name>::pointer_t username(g_username.get());
+    if(username->f_id == f_uid)
+    {
+        return username->f_name;
+    }
 
+    // the UID changed since (i.e. setuid() was called), resolve the name
+    // of this environment UID once instead of once per message
+    //
+    std::call_once(f_username_once, [this]()
+        {
+            f_username = resolve_username(f_uid).f_name;
+        });
     return f_username;
 }
 
 
 std::string environment::get_groupname() const
 {
-    guard g;
+    lazy_value<id_name>::pointer_t groupname(g_groupname.get());
+    if(groupname->f_id == f_gid)
+    {
+        return groupname->f_name;
+    }
 
+    // the GID changed since (i.e. setgid() was called), resolve the name
+    // of this environment GID once instead of once per message
+    //
+    std::call_once(f_groupname_once, [this]()
+        {
+            f_groupname = resolve_groupname(f_gid).f_name;
+        });
     return f_groupname;
 }
 
 
 std::string environment::get_hostname() const
 {
-    guard g;
-
-    return f_hostname;
+    return *g_hostname.get();
 }
 
 
 std::string environment::get_domainname() const
 {
-    guard g;
-
-    return f_domainname;
+    return *g_domainname.get();
 }
 
 
 std::string environment::get_progname() const
 {
-    guard g;
-
-    return f_progname;
+    return get_diagnostic(DIAG_KEY_PROGNAME);
 }
 
 
 std::string environment::get_threadname() const
 {
-    guard g;
-
     return f_threadname;
 }
 
 
 std::string environment::get_boot_id() const
 {
-    guard g;
-
-    return f_boot_id;
+    return *g_boot_id.get();
 }
 
 
@@ -221,6 +370,27 @@ environment::pointer_t create_environment()
 }
 
 
+/** \brief Forget the cached process identity.
+ *
+ * The user name, group name, host name, domain name, and boot identifier
+ * are resolved once and cached. If one of these changes
+ * while your process is running (most likely, the hostname), call this
+ * function. The values will be resolved again the next time they get
+ * used.
+ *
+ * Note that existing messages are affected too if they did not get
+ * formatted yet.
+ */
+void refresh_identity()
+{
+    g_username.reset();
+    g_groupname.reset();
+    g_hostname.reset();
+    g_domainname.reset();
+    g_boot_id.reset();
+}
+
+
 
 
 
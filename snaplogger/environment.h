@@ -35,6 +35,7 @@
 // C++
 //
 #include    <memory>
+#include    <mutex>
 #include    <string>
 
 
@@ -72,17 +73,18 @@ private:
     pid_t               f_pid = -1;
     gid_t               f_gid = -1;
     pid_t               f_tid = -1;
-    std::string         f_username = std::string();
-    std::string         f_groupname = std::string();
-    std::string         f_hostname = std::string();
-    std::string         f_domainname = std::string();
-    std::string         f_progname = std::string();
     std::string         f_threadname = std::string();
-    std::string         f_boot_id = std::string();
+    mutable std::once_flag
+                        f_username_once = std::once_flag();
+    mutable std::string f_username = std::string();
+    mutable std::once_flag
+                        f_groupname_once = std::once_flag();
+    mutable std::string f_groupname = std::string();
 };
 
 
 environment::pointer_t  create_environment();
+void                    refresh_identity();
 
 
 } // snaplogger namespace
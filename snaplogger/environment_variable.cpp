@@ -46,9 +46,21 @@ namespace
 {
 
 
-DEFINE_LOGGER_VARIABLE(env)
+DEFINE_COMPILED_LOGGER_VARIABLE(env, std::string)
 {
-    auto params(get_params());
+    char const * env(getenv(f_plan.c_str()));
+    if(env != nullptr)
+    {
+        value += env;
+    }
+
+    variable::process_value(msg, value);
+}
+
+
+COMPILE_LOGGER_VARIABLE(env)
+{
+    auto const & params(get_params());
     if(params.empty())
     {
         throw invalid_variable("the ${env:...} variable must have a \"name\" parameter.");
@@ -57,18 +69,11 @@ DEFINE_LOGGER_VARIABLE(env)
     {
         throw invalid_variable("the ${env:...} variable first parameter must be its \"name\" parameter.");
     }
-    std::string const env_name(params[0]->get_value());
-    if(env_name.empty())
+    f_plan = params[0]->get_value();
+    if(f_plan.empty())
     {
         throw invalid_variable("the ${env:name=...} variable parameter cannot be empty.");
     }
-    char const * env(getenv(env_name.c_str()));
-    if(env != nullptr)
-    {
-        value += env;
-    }
-
-    variable::process_value(msg, value);
 }
 
 
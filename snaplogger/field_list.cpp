@@ -0,0 +1,494 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/snaplogger
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Implementation of the typed fields.
+ *
+ * The field values are kept in their native type and only converted to
+ * a string when required. The names used by formats and default fields
+ * are interned in a table which lives as long as the process so the
+ * lists only keep pointers to them. Names added to a message at run time
+ * are copied in the list entries instead, so they never take the lock
+ * of that table and do not grow it.
+ */
+
+// self
+//
+#include    "snaplogger/field_list.h"
+
+
+// cppthread
+//
+#include    <cppthread/guard.h>
+#include    <cppthread/mutex.h>
+
+
+// C++
+//
+#include    <charconv>
+#include    <set>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace snaplogger
+{
+
+
+namespace
+{
+
+
+
+/** \brief The table of interned field names.
+ *
+ * The table is created on first use so it is available to the static
+ * initializers of other translation units. It is never deleted since
+ * the lists may still reference its names while the process exits.
+ */
+struct field_names
+{
+    cppthread::mutex                        f_mutex = cppthread::mutex();
+    std::set<std::string, std::less<>>      f_names = std::set<std::string, std::less<>>();
+};
+
+
+field_names & get_field_names()
+{
+    static field_names * names(new field_names);
+    return *names;
+}
+
+
+
+}
+// no name namespace
+
+
+
+field_value::field_value(std::string const & value)
+    : f_value(value)
+{
+}
+
+
+field_value::field_value(std::string && value)
+    : f_value(std::move(value))
+{
+}
+
+
+field_value::field_value(std::string_view value)
+    : f_value(std::string(value))
+{
+}
+
+
+field_value::field_value(char const * value)
+    : f_value(std::string(value == nullptr ? "" : value))
+{
+}
+
+
+field_value::field_value(char value)
+    : f_value(std::string(1, value))
+{
+}
+
+
+field_value::field_value(bool value)
+    : f_value(value)
+{
+}
+
+
+field_type_t field_value::get_type() const
+{
+    switch(f_value.index())
+    {
+    case 1:
+        return field_type_t::FIELD_TYPE_INTEGER;
+
+    case 2:
+        return field_type_t::FIELD_TYPE_FLOATING_POINT;
+
+    case 3:
+        return field_type_t::FIELD_TYPE_BOOLEAN;
+
+    case 4:
+        return field_type_t::FIELD_TYPE_UNSIGNED_INTEGER;
+
+    default:
+        return field_type_t::FIELD_TYPE_STRING;
+
+    }
+}
+
+
+field_value::value_t const & field_value::get_value() const
+{
+    return f_value;
+}
+
+
+/** \brief Convert the value to a string.
+ *
+ * Integers and floating points are converted with std::to_chars() which
+ * gives the shortest representation of the number. Booleans become
+ * "true" or "false".
+ *
+ * \return The value as a string.
+ */
+std::string field_value::to_string() const
+{
+    switch(get_type())
+    {
+    case field_type_t::FIELD_TYPE_STRING:
+        return std::get<std::string>(f_value);
+
+    case field_type_t::FIELD_TYPE_INTEGER:
+        return std::to_string(std::get<std::int64_t>(f_value));
+
+    case field_type_t::FIELD_TYPE_FLOATING_POINT:
+        {
+            char buf[32];
+            std::to_chars_result const r(std::to_chars(buf, buf + sizeof(buf), std::get<double>(f_value)));
+            return std::string(buf, r.ptr);
+        }
+
+    case field_type_t::FIELD_TYPE_BOOLEAN:
+        return std::get<bool>(f_value) ? "true" : "false";
+
+    case field_type_t::FIELD_TYPE_UNSIGNED_INTEGER:
+        return std::to_string(std::get<std::uint64_t>(f_value));
+
+    }
+
+    return std::string();
+}
+
+
+/** \brief Get the unique copy of a field name.
+ *
+ * Field names are saved once in a table and never released. This allows
+ * field lists to be copied without copying their names.
+ *
+ * This function locks a mutex. It is expected to be called when a format
+ * gets parsed or a default field gets added, not each time a message
+ * is logged.
+ *
+ * \param[in] name  The name of the field.
+ *
+ * \return A pointer to the interned copy of \p name.
+ */
+std::string const * intern_field_name(std::string_view name)
+{
+    field_names & names(get_field_names());
+    cppthread::guard lock(names.f_mutex);
+
+    auto it(names.f_names.find(name));
+    if(it == names.f_names.end())
+    {
+        it = names.f_names.emplace(name).first;
+    }
+    return &*it;
+}
+
+
+field_list::field_list(field_list const & rhs)
+{
+    *this = rhs;
+}
+
+
+/** \brief Copy a list of fields.
+ *
+ * Only the fields in use get copied. The entries of this list keep
+ * their string buffers so a message reused from a pool does not need
+ * to allocate memory for its fields again.
+ *
+ * \param[in] rhs  The list to copy.
+ *
+ * \return A reference to this list.
+ */
+field_list & field_list::operator = (field_list const & rhs)
+{
+    if(this != &rhs)
+    {
+        clear();
+        for(std::size_t idx(0); idx < rhs.f_size; ++idx)
+        {
+            entry_t const & e(rhs.at(idx));
+            if(e.f_name == nullptr)
+            {
+                append(e.f_inline_name).f_value = e.f_value;
+            }
+            else
+            {
+                append(e.f_name).f_value = e.f_value;
+            }
+        }
+    }
+    return *this;
+}
+
+
+bool field_list::empty() const
+{
+    return f_size == 0;
+}
+
+
+std::size_t field_list::size() const
+{
+    return f_size;
+}
+
+
+void field_list::clear()
+{
+    f_size = 0;
+    f_more.clear();
+}
+
+
+/** \brief Set a field.
+ *
+ * The name is not interned. When not already defined, the field gets
+ * appended with a copy of \p name. A list reused from the message pool
+ * keeps the buffers of its entries so this copy rarely allocates.
+ *
+ * \param[in] name  The name of the field.
+ * \param[in] value  The new value of the field.
+ */
+void field_list::set(std::string const & name, field_value const & value)
+{
+    for(std::size_t idx(0); idx < f_size; ++idx)
+    {
+        entry_t & e(at(idx));
+        if(e.name() == name)
+        {
+            e.f_value = value;
+            return;
+        }
+    }
+
+    append(name).f_value = value;
+}
+
+
+/** \brief Set a field using an interned name.
+ *
+ * This version avoids interning the name again. The \p name pointer
+ * must have been returned by intern_field_name().
+ *
+ * \param[in] name  The interned name of the field.
+ * \param[in] value  The new value of the field.
+ */
+void field_list::set(std::string const * name, field_value const & value)
+{
+    for(std::size_t idx(0); idx < f_size; ++idx)
+    {
+        entry_t & e(at(idx));
+        if(e.is(name))
+        {
+            e.f_value = value;
+            return;
+        }
+    }
+
+    append(name).f_value = value;
+}
+
+
+bool field_list::remove(std::string const & name)
+{
+    for(std::size_t idx(0); idx < f_size; ++idx)
+    {
+        if(at(idx).name() == name)
+        {
+            for(++idx; idx < f_size; ++idx)
+            {
+                std::swap(at(idx - 1), at(idx));
+            }
+            --f_size;
+            if(f_size >= INLINE_FIELDS)
+            {
+                f_more.pop_back();
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+field_value const * field_list::find(std::string const & name) const
+{
+    for(std::size_t idx(0); idx < f_size; ++idx)
+    {
+        entry_t const & e(at(idx));
+        if(e.name() == name)
+        {
+            return &e.f_value;
+        }
+    }
+
+    return nullptr;
+}
+
+
+/** \brief Find a field using an interned name.
+ *
+ * Entries with an interned name get compared by pointer. The entries
+ * which were given a name at run time are compared by string.
+ * The \p name pointer must have been returned by intern_field_name().
+ *
+ * \param[in] name  The interned name of the field.
+ *
+ * \return A pointer to the value or nullptr if not defined.
+ */
+field_value const * field_list::find(std::string const * name) const
+{
+    for(std::size_t idx(0); idx < f_size; ++idx)
+    {
+        entry_t const & e(at(idx));
+        if(e.is(name))
+        {
+            return &e.f_value;
+        }
+    }
+
+    return nullptr;
+}
+
+
+/** \brief Get the value of a field as a string.
+ *
+ * \param[in] name  The name of the field to retrieve.
+ *
+ * \return The value converted to a string or an empty string if the
+ * field is not defined.
+ */
+std::string field_list::get(std::string const & name) const
+{
+    field_value const * value(find(name));
+    if(value == nullptr)
+    {
+        return std::string();
+    }
+    return value->to_string();
+}
+
+
+std::string const & field_list::get_name(std::size_t idx) const
+{
+    return at(idx).name();
+}
+
+
+field_value const & field_list::get_value(std::size_t idx) const
+{
+    return at(idx).f_value;
+}
+
+
+/** \brief Convert the list to a map of strings.
+ *
+ * The map is sorted by field name and all the values get converted to
+ * strings.
+ *
+ * \return The fields in a map.
+ */
+field_map_t field_list::to_map() const
+{
+    field_map_t result;
+    for(std::size_t idx(0); idx < f_size; ++idx)
+    {
+        entry_t const & e(at(idx));
+        result[e.name()] = e.f_value.to_string();
+    }
+    return result;
+}
+
+
+field_list::entry_t & field_list::at(std::size_t idx)
+{
+    if(idx < INLINE_FIELDS)
+    {
+        return f_inline[idx];
+    }
+    return f_more[idx - INLINE_FIELDS];
+}
+
+
+field_list::entry_t const & field_list::at(std::size_t idx) const
+{
+    if(idx < INLINE_FIELDS)
+    {
+        return f_inline[idx];
+    }
+    return f_more[idx - INLINE_FIELDS];
+}
+
+
+field_list::entry_t & field_list::append(std::string const * name)
+{
+    if(f_size >= INLINE_FIELDS)
+    {
+        f_more.emplace_back();
+    }
+    entry_t & e(at(f_size));
+    ++f_size;
+    e.f_name = name;
+    return e;
+}
+
+
+field_list::entry_t & field_list::append(std::string const & name)
+{
+    entry_t & e(append(static_cast<std::string const *>(nullptr)));
+    e.f_inline_name = name;
+    return e;
+}
+
+
+std::string const & field_list::entry_t::name() const
+{
+    return f_name == nullptr ? f_inline_name : *f_name;
+}
+
+
+bool field_list::entry_t::is(std::string const * name) const
+{
+    if(f_name != nullptr)
+    {
+        return f_name == name;
+    }
+    return f_inline_name == *name;
+}
+
+
+
+} // snaplogger namespace
+// vim: ts=4 sw=4 et
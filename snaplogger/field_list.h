@@ -0,0 +1,188 @@
+// Copyright (c) 2013-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/snaplogger
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+/** \file
+ * \brief Typed fields attached to messages.
+ *
+ * A message can be given any number of fields. Each field has a name
+ * and a typed value: a string, an integer, a floating point number, or
+ * a boolean. The value gets converted to text only when a format
+ * actually renders it (i.e. with `${field:name=...}` or `${fields}`).
+ *
+ * The field_list keeps the first few fields in an inline array and
+ * searches them linearly, which is faster than a map for the handful
+ * of fields a message usually has. The names known ahead of time (the
+ * ones found in formats and the default fields) are interned so they
+ * can be compared by pointer. The other names are saved in the entry
+ * itself.
+ */
+
+
+// C++
+//
+#include    <array>
+#include    <concepts>
+#include    <cstdint>
+#include    <limits>
+#include    <map>
+#include    <memory>
+#include    <string>
+#include    <string_view>
+#include    <variant>
+#include    <vector>
+
+
+
+namespace snaplogger
+{
+
+
+
+typedef std::map<std::string, std::string>      field_map_t;
+
+
+enum class field_type_t
+{
+    FIELD_TYPE_STRING,
+    FIELD_TYPE_INTEGER,
+    FIELD_TYPE_FLOATING_POINT,
+    FIELD_TYPE_BOOLEAN,
+    FIELD_TYPE_UNSIGNED_INTEGER,        // only used for values larger than INT64_MAX
+};
+
+
+namespace detail
+{
+// the character types are integral types which are not numbers
+//
+template<typename T>
+concept character_type = std::same_as<T, char>
+                      || std::same_as<T, wchar_t>
+                      || std::same_as<T, char8_t>
+                      || std::same_as<T, char16_t>
+                      || std::same_as<T, char32_t>;
+}
+// detail namespace
+
+
+class field_value
+{
+public:
+    typedef std::variant<std::string, std::int64_t, double, bool, std::uint64_t>
+                                                                    value_t;
+
+                                field_value() = default;
+                                field_value(std::string const & value);
+                                field_value(std::string && value);
+                                field_value(std::string_view value);
+                                field_value(char const * value);
+                                field_value(char value);
+                                field_value(bool value);
+
+    // a lone UTF-8, UTF-16, or UTF-32 code unit may not be a character
+    //
+    template<detail::character_type T>
+        requires (!std::same_as<T, char>)
+                                field_value(T value) = delete;
+
+    template<std::signed_integral T>
+        requires (!detail::character_type<T>)
+                                field_value(T value)
+                                    : f_value(static_cast<std::int64_t>(value))
+                                {
+                                }
+
+    template<std::unsigned_integral T>
+        requires (!detail::character_type<T> && !std::same_as<T, bool>)
+                                field_value(T value)
+                                    : f_value(value <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())
+                                                ? value_t(static_cast<std::int64_t>(value))
+                                                : value_t(static_cast<std::uint64_t>(value)))
+                                {
+                                }
+
+    template<std::floating_point T>
+                                field_value(T value)
+                                    : f_value(static_cast<double>(value))
+                                {
+                                }
+
+    field_type_t                get_type() const;
+    value_t const &             get_value() const;
+    std::string                 to_string() const;
+
+private:
+    value_t                     f_value = value_t();
+};
+
+
+std::string const *             intern_field_name(std::string_view name);
+
+
+class field_list
+{
+public:
+    typedef std::shared_ptr<field_list const>   pointer_t;
+
+    static constexpr std::size_t    INLINE_FIELDS = 8;
+
+                                field_list() = default;
+                                field_list(field_list const & rhs);
+
+    field_list &                operator = (field_list const & rhs);
+
+    bool                        empty() const;
+    std::size_t                 size() const;
+    void                        clear();
+    void                        set(std::string const & name, field_value const & value);
+    void                        set(std::string const * name, field_value const & value);
+    bool                        remove(std::string const & name);
+    field_value const *         find(std::string const & name) const;
+    field_value const *         find(std::string const * name) const;
+    std::string                 get(std::string const & name) const;
+    std::string const &         get_name(std::size_t idx) const;
+    field_value const &         get_value(std::size_t idx) const;
+    field_map_t                 to_map() const;
+
+private:
+    struct entry_t
+    {
+        std::string const &     name() const;
+        bool                    is(std::string const * name) const;
+
+        std::string const *     f_name = nullptr;
+        std::string             f_inline_name = std::string();
+        field_value             f_value = field_value();
+    };
+
+    entry_t &                   at(std::size_t idx);
+    entry_t const &             at(std::size_t idx) const;
+    entry_t &                   append(std::string const * name);
+    entry_t &                   append(std::string const & name);
+
+    std::array<entry_t, INLINE_FIELDS>
+                                f_inline = std::array<entry_t, INLINE_FIELDS>();
+    std::vector<entry_t>        f_more = std::vector<entry_t>();
+    std::size_t                 f_size = 0;
+};
+
+
+
+} // snaplogger namespace
+// vim: ts=4 sw=4 et
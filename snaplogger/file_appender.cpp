@@ -27,7 +27,6 @@
 #include    "snaplogger/file_appender.h"
 
 #include    "snaplogger/exception.h"
-#include    "snaplogger/guard.h"
 #include    "snaplogger/map_diagnostic.h"
 #include    "snaplogger/syslog_appender.h"
 
@@ -37,6 +36,11 @@
 #include    <advgetopt/validator_size.h>
 
 
+// cppthread
+//
+#include    <cppthread/guard.h>
+
+
 // snapdev
 //
 #include    <snapdev/lockfile.h>
@@ -93,10 +97,10 @@ file_appender::~file_appender()
 
 void file_appender::set_config(advgetopt::getopt const & opts)
 {
-    guard g;
-
     appender::set_config(opts);
 
+    cppthread::guard lock(get_mutex());
+
     // PATH
     //
     std::string const path_field(get_name() + "::path");
@@ -217,7 +221,7 @@ void file_appender::set_config(advgetopt::getopt const & opts)
 
 void file_appender::reopen()
 {
-    guard g;
+    cppthread::guard lock(get_mutex());
 
     f_fd.reset();
     f_initialized = false;
@@ -226,7 +230,7 @@ void file_appender::reopen()
 
 void file_appender::set_filename(std::string const & filename)
 {
-    guard g;
+    cppthread::guard lock(get_mutex());
 
     if(f_filename != filename)
     {
@@ -238,8 +242,6 @@ void file_appender::set_filename(std::string const & filename)
 
 bool file_appender::process_message(message const & msg, std::string const & formatted_message)
 {
-    guard g;
-
     for(;;)
     {
         switch(check_auto_rotate())
@@ -389,9 +391,9 @@ bool file_appender::open()
     {
         // try to generate a filename
         //
-        map_diagnostics_t map(get_map_diagnostics());
-        auto const it(map.find("progname"));
-        if(it == map.end())
+        map_diagnostics_pointer_t const diagnostics(get_map_diagnostics_snapshot());
+        auto const it(diagnostics->find("progname"));
+        if(it == diagnostics->end())
         {
             return false;
         }
@@ -31,10 +31,16 @@
 #include    "snaplogger/exception.h"
 
 
+// cppthread
+//
+#include    <cppthread/guard.h>
+#include    <cppthread/mutex.h>
+
+
 // C++
 //
-#include    <numeric>
 #include    <iostream>
+#include    <map>
 
 
 // last include
@@ -231,13 +237,17 @@ public:
         {
             return false;
         }
-        f_variables.push_back(var);
 
         tok = get_token();
         for(;;)
         {
             if(tok == token_t::TOKEN_END)
             {
+                // only keep the variable once it is complete so a
+                // failed parse does not leave a half defined variable
+                //
+                var->compile();
+                f_variables.push_back(var);
                 break;
             }
             if(tok != token_t::TOKEN_COLON)
@@ -291,8 +301,9 @@ public:
                     throw logger_logic_error("variable type \"direct\" not registered?");
                 }
                 param::pointer_t p(std::make_shared<param>("msg"));
-                var->add_param(p);
                 p->set_value(text);
+                var->add_param(p);
+                var->compile();
                 f_variables.push_back(var);
             }
         };
@@ -350,6 +361,26 @@ private:
 };
 
 
+/** \brief The cache of shared formats.
+ *
+ * Appenders often use the exact same format string. The cache lets them
+ * share one compiled format. It only keeps weak pointers so a format
+ * which is not used anymore gets released.
+ */
+struct format_cache
+{
+    cppthread::mutex                                f_mutex = cppthread::mutex();
+    std::map<std::string, std::weak_ptr<format>>    f_formats = std::map<std::string, std::weak_ptr<format>>();
+};
+
+
+format_cache & get_format_cache()
+{
+    static format_cache * cache(new format_cache);
+    return *cache;
+}
+
+
 
 }
 // no name namespace
@@ -369,24 +400,118 @@ std::string format::get_format() const
 }
 
 
-std::string format::process_message(message const & msg, bool ignore_on_no_repeat)
+/** \brief Render a message in a new string.
+ *
+ * The string is reserved using the size of the previous message rendered
+ * with this format so it usually does not need to grow while the
+ * variables get appended.
+ *
+ * \param[in] msg  The message to render.
+ * \param[in] ignore_on_no_repeat  Whether to skip the variables which are
+ * ignored by the no-repeat feature.
+ *
+ * \return The rendered message.
+ */
+std::string format::process_message(message const & msg, bool ignore_on_no_repeat) const
 {
-    return std::accumulate(
-              f_variables.begin()
-            , f_variables.end()
-            , std::string()
-            , [&msg, &ignore_on_no_repeat](std::string const & r, variable::pointer_t v)
-            {
-                if(ignore_on_no_repeat
-                && v->ignore_on_no_repeat())
-                {
-                    // do not include this variable to generate the "no-repeat"
-                    // message (i.e. probably a time base message)
-                    //
-                    return r;
-                }
-                return r + v->get_value(msg);
-            });
+    std::string result;
+    result.reserve(f_size_hint.load(std::memory_order_relaxed));
+    process_message(msg, result, ignore_on_no_repeat);
+    return result;
+}
+
+
+/** \brief Render a message at the end of \p output.
+ *
+ * Each variable appends its value directly to \p output. Callers which
+ * render many messages can reuse the same string to avoid allocating
+ * a new buffer each time.
+ *
+ * \param[in] msg  The message to render.
+ * \param[in,out] output  The string where the message gets appended.
+ * \param[in] ignore_on_no_repeat  Whether to skip the variables which are
+ * ignored by the no-repeat feature.
+ */
+void format::process_message(message const & msg, std::string & output, bool ignore_on_no_repeat) const
+{
+    std::size_t const start(output.length());
+    for(auto const & v : f_variables)
+    {
+        if(ignore_on_no_repeat
+        && v->ignore_on_no_repeat())
+        {
+            // do not include this variable to generate the "no-repeat"
+            // message (i.e. probably a time base message)
+            //
+            continue;
+        }
+        v->append_value(msg, output);
+    }
+
+    if(!ignore_on_no_repeat)
+    {
+        f_size_hint.store(output.length() - start, std::memory_order_relaxed);
+    }
+}
+
+
+/** \brief Get a format shared with other users of the same string.
+ *
+ * A format does not change once compiled so all the appenders using the
+ * same format string can share the same object. This function returns
+ * the existing format if one is still in use and compiles a new one
+ * otherwise.
+ *
+ * This function is expected to be called while loading the
+ * configuration. The compilation throws if the format is not valid.
+ *
+ * \param[in] f  The format string.
+ *
+ * \return A pointer to the compiled format.
+ */
+format::pointer_t get_shared_format(std::string const & f)
+{
+    format_cache & cache(get_format_cache());
+    cppthread::guard lock(cache.f_mutex);
+
+    auto it(cache.f_formats.find(f));
+    if(it != cache.f_formats.end())
+    {
+        format::pointer_t existing(it->second.lock());
+        if(existing != nullptr)
+        {
+            return existing;
+        }
+    }
+
+    // compile before we touch the cache so an invalid format does not
+    // leave an entry behind
+    //
+    format::pointer_t result(std::make_shared<format>(f));
+
+    std::erase_if(cache.f_formats, [](auto const & entry)
+        {
+            return entry.second.expired();
+        });
+    cache.f_formats[f] = result;
+
+    return result;
+}
+
+
+/** \brief Forget the formats compiled so far.
+ *
+ * The formats resolve their functions when compiled. Once a new function
+ * gets registered, the formats in the cache may be missing it, so the
+ * cache gets cleared and the next call to get_shared_format() compiles
+ * a new format. The formats already in use by appenders are not affected.
+ */
+void clear_shared_formats()
+{
+    format_cache & cache(get_format_cache());
+    cppthread::guard lock(cache.f_mutex);
+
+    cache.f_formats.clear();
 }
 
 
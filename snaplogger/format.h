@@ -22,6 +22,10 @@
  *
  * This file declares the format class used to transform a message with
  * the administrator defined format.
+ *
+ * A format gets compiled once: each variable decodes its parameters
+ * when the format is created so errors are reported at that time and
+ * rendering a message does not have to parse anything.
  */
 
 
@@ -30,6 +34,11 @@
 #include    <snaplogger/variable.h>
 
 
+// C++
+//
+#include    <atomic>
+
+
 
 namespace snaplogger
 {
@@ -45,14 +54,21 @@ public:
                         format(std::string const & f);
 
     std::string         get_format() const;
-    std::string         process_message(message const & msg, bool ignore_on_no_repeat = false);
+    std::string         process_message(message const & msg, bool ignore_on_no_repeat = false) const;
+    void                process_message(message const & msg, std::string & output, bool ignore_on_no_repeat = false) const;
 
 private:
     std::string const   f_format;
     variable::vector_t  f_variables = variable::vector_t();
+    mutable std::atomic<std::size_t>
+                        f_size_hint = 0;
 };
 
 
+format::pointer_t       get_shared_format(std::string const & f);
+void                    clear_shared_formats();
+
+
 
 
 
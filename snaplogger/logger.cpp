@@ -39,6 +39,13 @@
 #include    <serverplugins/paths.h>
 
 
+// C++
+//
+#include    <bit>
+#include    <bitset>
+#include    <map>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
@@ -61,7 +68,8 @@ namespace
 
 constexpr std::size_t const g_maximum_early_messages = 100;
 bool                        g_first_instance = true;
-logger::pointer_t *         g_instance = nullptr;
+std::atomic<logger::pointer_t *>
+                            g_instance = nullptr;
 std::string                 g_default_plugin_paths = std::string("/usr/local/lib/snaplogger/plugins:/usr/lib/snaplogger/plugins");
 
 
@@ -82,21 +90,13 @@ struct auto_delete_logger
         //       may try to re-create the snaplogger anew
         //
 //std::cerr << "--- auto deleting snaplogger now...\n";
-        logger::pointer_t * ptr(nullptr);
-        {
-            guard g;
-            ptr = g_instance;
-        }
+        logger::pointer_t * ptr(g_instance.load());
         if(ptr != nullptr)
         {
             (*ptr)->ready();
         }
 
-        ptr = nullptr;
-        {
-            guard g;
-            std::swap(ptr, g_instance);
-        }
+        ptr = g_instance.exchange(nullptr);
         if(ptr != nullptr)
         {
             (*ptr)->shutdown();
@@ -108,6 +108,57 @@ struct auto_delete_logger
 auto_delete_logger          g_logger_deleter = auto_delete_logger();
 
 
+/** \brief Track the appenders which were sent a message.
+ *
+ * The appenders are identified by their index in the configuration
+ * targets. Up to 64 appenders, no memory gets allocated.
+ */
+class processed_appenders
+{
+public:
+    processed_appenders(std::size_t count)
+    {
+        if(count > INLINE_COUNT)
+        {
+            f_more.resize(count - INLINE_COUNT);
+        }
+    }
+
+    /** \brief Mark an appender as processed.
+     *
+     * \param[in] idx  The index of the appender.
+     *
+     * \return true if the appender was not yet processed.
+     */
+    bool insert(std::size_t idx)
+    {
+        if(idx < INLINE_COUNT)
+        {
+            if(f_inline[idx])
+            {
+                return false;
+            }
+            f_inline[idx] = true;
+            return true;
+        }
+
+        idx -= INLINE_COUNT;
+        if(f_more[idx])
+        {
+            return false;
+        }
+        f_more[idx] = true;
+        return true;
+    }
+
+private:
+    static constexpr std::size_t    INLINE_COUNT = 64;
+
+    std::bitset<INLINE_COUNT>       f_inline = std::bitset<INLINE_COUNT>();
+    std::vector<bool>               f_more = std::vector<bool>();
+};
+
+
 //void __attribute__((destructor)) delete_logger()
 //{
 //    // TODO: determine whether the shutdown() could be called before
@@ -149,6 +200,38 @@ auto_delete_logger          g_logger_deleter = auto_delete_logger();
 
 
 
+namespace detail
+{
+
+
+/** \brief The lowest severity published for the SNAP_LOG_...() macros.
+ *
+ * This value is a copy of the value returned by the
+ * logger::get_lowest_severity() function, lowered to the fatal severity
+ * when that one is smaller. It gets updated each time any of those
+ * levels changes so the macros can check a message severity without
+ * having to lock the guard.
+ *
+ * By default, it is set to SEVERITY_ALL since without any appender the
+ * logger accepts all the messages.
+ */
+std::atomic<severity_t>     g_published_lowest_severity = severity_t::SEVERITY_ALL;
+
+
+/** \brief Whether the logger is asynchronous.
+ *
+ * This is a copy of the logger f_asynchronous flag which messages can
+ * check without locking the guard. When true, the SNAP_LOG_..._FMT()
+ * macros defer the formatting of their arguments to the logger thread.
+ */
+std::atomic<bool>           g_published_asynchronous = false;
+
+
+}
+// detail namespace
+
+
+
 SERVERPLUGINS_START_SERVER(logger)
     , ::serverplugins::description("The logger plugin extensions.")
     , ::serverplugins::help_uri("https://snapwebsites.org/help")
@@ -158,6 +241,7 @@ SERVERPLUGINS_END_SERVER(logger)
 
 logger::logger()
     : server(g_logger_factory)
+    , f_config(std::make_shared<config_snapshot>())
 {
 }
 
@@ -169,9 +253,18 @@ logger::~logger()
 
 logger::pointer_t logger::get_instance()
 {
+    // once created, the instance is returned without locking the guard
+    //
+    logger::pointer_t * instance(g_instance.load(std::memory_order_acquire));
+    if(instance != nullptr)
+    {
+        return *instance;
+    }
+
     guard g;
 
-    if(g_instance == nullptr)
+    instance = g_instance.load(std::memory_order_relaxed);
+    if(instance == nullptr)
     {
         if(!g_first_instance)
         {
@@ -182,14 +275,14 @@ logger::pointer_t logger::get_instance()
 
         // note that we create a `private_logger` object
         //
-        logger::pointer_t * instance = new logger::pointer_t();
+        instance = new logger::pointer_t();
         instance->reset(new private_logger());
         (*instance)->complete_plugin_initialization();
 
-        g_instance = instance;
+        g_instance.store(instance, std::memory_order_release);
     }
 
-    return *g_instance;
+    return *instance;
 }
 
 
@@ -207,21 +300,28 @@ void logger::reset()
     guard g;
 
     set_asynchronous(false);
-    f_appenders.clear();
+    std::shared_ptr<config_snapshot> config(copy_config());
+    config->f_appenders.clear();
+    publish_config(config);
     f_lowest_severity = severity_t::SEVERITY_OFF;
+    publish_lowest_severity();
 }
 
 
 void logger::ready()
 {
-    f_ready = true;
+    {
+        guard g;
+
+        f_ready.store(true, std::memory_order_release);
+    }
 
     if(f_hide_if_banner_only)
     {
         bool output(false);
         for(auto m : f_early_messages)
         {
-            if(!m->get_components().contains(g_banner_component))
+            if(!m->has_component(g_banner_component))
             {
                 output = true;
                 break;
@@ -278,36 +378,34 @@ void logger::load_plugins(std::string const & plugin_paths)
 
 bool logger::is_configured() const
 {
-    guard g;
-
-    return !f_appenders.empty();
+    return !get_config()->f_appenders.empty();
 }
 
 
 bool logger::has_appender(std::string const & type) const
 {
+    config_snapshot::pointer_t config(get_config());
     return std::find_if(
-          f_appenders.begin()
-        , f_appenders.end()
+          config->f_appenders.begin()
+        , config->f_appenders.end()
         , [&type](auto a)
         {
             return type == a->get_type();
-        }) != f_appenders.end();
+        }) != config->f_appenders.end();
 }
 
 
 appender::pointer_t logger::get_appender(std::string const & name) const
 {
-    guard g;
-
+    config_snapshot::pointer_t config(get_config());
     auto it(std::find_if(
-          f_appenders.begin()
-        , f_appenders.end()
+          config->f_appenders.begin()
+        , config->f_appenders.end()
         , [&name](auto a)
         {
             return name == a->get_name();
         }));
-    if(it == f_appenders.end())
+    if(it == config->f_appenders.end())
     {
         return appender::pointer_t();
     }
@@ -318,8 +416,7 @@ appender::pointer_t logger::get_appender(std::string const & name) const
 
 appender::vector_t logger::get_appenders() const
 {
-    guard g;
-    return f_appenders;
+    return get_config()->f_appenders;
 }
 
 
@@ -366,9 +463,10 @@ void logger::set_config(advgetopt::getopt const & params)
         }
     }
 
-    guard g;
-
-    for(auto a : f_appenders)
+    // the guard is not locked here because the appenders lock their
+    // own mutex while being configured
+    //
+    for(auto a : get_appenders())
     {
         a->set_config(params);
     }
@@ -377,9 +475,7 @@ void logger::set_config(advgetopt::getopt const & params)
 
 void logger::reopen()
 {
-    guard g;
-
-    for(auto a : f_appenders)
+    for(auto a : get_appenders())
     {
         a->reopen();
     }
@@ -390,17 +486,18 @@ void logger::add_appender(appender::pointer_t a)
 {
     guard g;
 
+    std::shared_ptr<config_snapshot> config(copy_config());
     if(a->unique())
     {
         std::string const type(a->get_type());
         auto it(std::find_if(
-                  f_appenders.begin()
-                , f_appenders.end()
+                  config->f_appenders.begin()
+                , config->f_appenders.end()
                 , [&type](auto app)
                 {
                     return type == app->get_type();
                 }));
-        if(it != f_appenders.end())
+        if(it != config->f_appenders.end())
         {
             // the console is a pretty special type because it can't be
             // added twice but it may get added early because an error
@@ -431,7 +528,8 @@ void logger::add_appender(appender::pointer_t a)
         }
     }
 
-    f_appenders.push_back(a);
+    config->f_appenders.push_back(a);
+    publish_config(config);
 
     severity_changed(a->get_severity());
 }
@@ -545,7 +643,7 @@ severity_t logger::get_lowest_severity() const
 {
     guard g;
 
-    if(f_appenders.empty())
+    if(get_config()->f_appenders.empty())
     {
         // we do not know the level yet, we do not have the appenders
         // yet... so accept anything at this point
@@ -582,7 +680,10 @@ severity_t logger::get_lowest_severity() const
  */
 void logger::override_lowest_severity(severity_t severity_level)
 {
+    guard g;
+
     f_lowest_replacements.push_back(severity_level);
+    publish_lowest_severity();
 }
 
 
@@ -598,28 +699,57 @@ void logger::override_lowest_severity(severity_t severity_level)
  */
 void logger::restore_lowest_severity()
 {
+    guard g;
+
     if(!f_lowest_replacements.empty())
     {
         f_lowest_replacements.pop_back();
+        publish_lowest_severity();
     }
 }
 
 
+/** \brief Publish the lowest severity for the SNAP_LOG_...() macros.
+ *
+ * The macros check the severity of a message before creating it. To
+ * avoid locking the guard each time, they read an atomic copy of the
+ * current lowest severity which this function updates.
+ *
+ * If a fatal severity is defined and it is lower than the lowest
+ * severity, then the fatal severity is used instead. Otherwise such
+ * messages would be skipped and the fatal error would never be raised.
+ *
+ * \note
+ * This function must be called with the guard locked.
+ */
+void logger::publish_lowest_severity()
+{
+    severity_t lowest(get_lowest_severity());
+    if(f_fatal_severity != severity_t::SEVERITY_OFF
+    && f_fatal_severity < lowest)
+    {
+        lowest = f_fatal_severity;
+    }
+    detail::g_published_lowest_severity.store(lowest, std::memory_order_relaxed);
+}
+
+
 void logger::set_severity(severity_t severity_level)
 {
     guard g;
 
     f_lowest_severity = severity_level;
-    for(auto a : f_appenders)
+    for(auto a : get_config()->f_appenders)
     {
         a->set_severity(severity_level);
     }
+    publish_lowest_severity();
 }
 
 
 void logger::reduce_severity(severity_t severity_level)
 {
-    for(auto a : f_appenders)
+    for(auto a : get_appenders())
     {
         a->reduce_severity(severity_level);
     }
@@ -640,8 +770,9 @@ void logger::severity_changed(severity_t severity_level)
         // this happens very rarely while running, it's likely to happen
         // up to once per appender on initialization.
         //
-        auto const min(std::min_element(f_appenders.begin(), f_appenders.end()));
-        if(min == f_appenders.end())
+        config_snapshot::pointer_t config(get_config());
+        auto const min(std::min_element(config->f_appenders.begin(), config->f_appenders.end()));
+        if(min == config->f_appenders.end())
         {
             // I don't think this is possible because if there are no appenders
             // then we should not even get called; also the new level should
@@ -654,6 +785,12 @@ void logger::severity_changed(severity_t severity_level)
             f_lowest_severity = (*min)->get_severity();
         }
     }
+
+    publish_lowest_severity();
+
+    // the routing table depends on the severity of each appender
+    //
+    publish_config(copy_config());
 }
 
 
@@ -691,7 +828,9 @@ void logger::add_component_to_include(component::pointer_t comp)
 {
     guard g;
 
-    f_components_to_include.insert(comp);
+    std::shared_ptr<config_snapshot> config(copy_config());
+    config->f_components_to_include.set(comp->get_index());
+    publish_config(config);
 }
 
 
@@ -699,7 +838,9 @@ void logger::remove_component_to_include(component::pointer_t comp)
 {
     guard g;
 
-    f_components_to_include.erase(comp);
+    std::shared_ptr<config_snapshot> config(copy_config());
+    config->f_components_to_include.reset(comp->get_index());
+    publish_config(config);
 }
 
 
@@ -707,7 +848,9 @@ void logger::add_component_to_ignore(component::pointer_t comp)
 {
     guard g;
 
-    f_components_to_ignore.insert(comp);
+    std::shared_ptr<config_snapshot> config(copy_config());
+    config->f_components_to_ignore.set(comp->get_index());
+    publish_config(config);
 }
 
 
@@ -715,7 +858,231 @@ void logger::remove_component_to_ignore(component::pointer_t comp)
 {
     guard g;
 
-    f_components_to_ignore.erase(comp);
+    std::shared_ptr<config_snapshot> config(copy_config());
+    config->f_components_to_ignore.reset(comp->get_index());
+    publish_config(config);
+}
+
+
+/** \brief Get the current configuration snapshot.
+ *
+ * The snapshot can be used without locking the guard. It remains valid
+ * as long as the returned pointer is kept, even if the configuration
+ * changes in the meantime.
+ *
+ * \return The current configuration snapshot.
+ */
+logger::config_snapshot::pointer_t logger::get_config() const
+{
+    return f_config.load(std::memory_order_acquire);
+}
+
+
+/** \brief Copy the current configuration.
+ *
+ * This function is used by the functions modifying the configuration.
+ * They have to lock the guard, copy the configuration, modify the copy,
+ * and then call publish_config().
+ *
+ * \return A modifiable copy of the current configuration.
+ */
+std::shared_ptr<logger::config_snapshot> logger::copy_config() const
+{
+    return std::make_shared<config_snapshot>(*get_config());
+}
+
+
+/** \brief Publish a new configuration.
+ *
+ * Messages being sent by other threads continue to use the previous
+ * configuration. New messages use \p config.
+ *
+ * \note
+ * This function must be called with the guard locked.
+ *
+ * \param[in] config  The new configuration.
+ */
+void logger::publish_config(std::shared_ptr<config_snapshot> config)
+{
+    config->build_routes(f_normal_component);
+    f_config.store(config, std::memory_order_release);
+}
+
+
+/** \brief Compute the list of appenders each message gets sent to.
+ *
+ * The appenders are deduplicated and the fallback only appenders are
+ * removed from the main list. The fallbacks of each appender are
+ * searched by name once here instead of each time an appender fails.
+ *
+ * The result is saved in f_routes and f_targets. A fallback which is
+ * not otherwise a main appender gets added at the end of f_targets.
+ *
+ * The function also compiles the routing table. For each severity, it
+ * saves a mask of the routes accepting it. The routes a message gets sent
+ * to are the routes found in the mask of its severity which share at
+ * least one component with the message.
+ *
+ * \param[in] normal_component  The component assumed by messages without
+ * any components.
+ */
+void logger::config_snapshot::build_routes(component::pointer_t normal_component)
+{
+    f_routes.clear();
+    f_targets.clear();
+    f_severity_routes.fill(0);
+    f_no_component_routes = 0;
+    f_normal_component.reset();
+    f_normal_component.set(normal_component->get_index());
+
+    std::map<appender *, std::size_t> indexes;
+    for(auto const & a : f_appenders)
+    {
+        if(a->is_fallback_only()
+        || indexes.contains(a.get()))
+        {
+            continue;
+        }
+        indexes[a.get()] = f_targets.size();
+        f_targets.push_back(a);
+        f_routes.push_back(route_t{ a, {}, a->get_component_mask() });
+    }
+
+    for(auto & r : f_routes)
+    {
+        advgetopt::string_list_t const fallback_appenders(r.f_appender->get_fallback_appenders());
+        for(auto const & name : fallback_appenders)
+        {
+            auto it(std::find_if(
+                  f_appenders.begin()
+                , f_appenders.end()
+                , [&name](auto const & a)
+                {
+                    return name == a->get_name();
+                }));
+            if(it == f_appenders.end())
+            {
+                // could not find that appender, ignore error
+                //
+                continue;
+            }
+
+            auto const idx(indexes.find(it->get()));
+            if(idx != indexes.end())
+            {
+                r.f_fallbacks.push_back(idx->second);
+            }
+            else
+            {
+                std::size_t const pos(f_targets.size());
+                indexes[it->get()] = pos;
+                f_targets.push_back(*it);
+                r.f_fallbacks.push_back(pos);
+            }
+        }
+    }
+
+    f_use_routing_table = f_routes.size() <= MAX_ROUTING_TABLE_ROUTES;
+    if(!f_use_routing_table)
+    {
+        return;
+    }
+
+    for(std::size_t idx(0); idx < f_routes.size(); ++idx)
+    {
+        appender::pointer_t const & a(f_routes[idx].f_appender);
+        route_mask_t const bit(static_cast<route_mask_t>(1) << idx);
+
+        for(std::size_t sev(static_cast<std::size_t>(a->get_severity()));
+            sev < f_severity_routes.size();
+            ++sev)
+        {
+            f_severity_routes[sev] |= bit;
+        }
+
+        // an appender without components only accepts messages without
+        // components
+        //
+        component::mask_t const & components(f_routes[idx].f_components);
+        if(components.none()
+        || (components & f_normal_component).any())
+        {
+            f_no_component_routes |= bit;
+        }
+    }
+}
+
+
+/** \brief Check whether the logger ignores a message.
+ *
+ * A message without components is viewed as a message with the normal
+ * component. The message is filtered out if one of its components is
+ * ignored or if components to include were defined and the message has
+ * none of them.
+ *
+ * \param[in] components  The mask of components of the message.
+ *
+ * \return true if the message must not be sent to any appender.
+ */
+bool logger::config_snapshot::is_filtered_out(component::mask_t const & components) const
+{
+    component::mask_t const & c(components.none() ? f_normal_component : components);
+    if((c & f_components_to_ignore).any())
+    {
+        return true;
+    }
+    return f_components_to_include.any()
+        && (c & f_components_to_include).none();
+}
+
+
+/** \brief Get the routes accepting a message.
+ *
+ * This function must only be called when f_use_routing_table is true.
+ *
+ * \param[in] sev  The severity of the message.
+ * \param[in] components  The components of the message.
+ *
+ * \return The mask of the routes which accept the message.
+ */
+logger::config_snapshot::route_mask_t logger::config_snapshot::get_routes(
+      severity_t sev
+    , component::mask_t const & components) const
+{
+    route_mask_t severity_routes(f_severity_routes[std::min(
+                              static_cast<std::size_t>(sev)
+                            , f_severity_routes.size() - 1)]);
+    if(components.none())
+    {
+        return severity_routes & f_no_component_routes;
+    }
+
+    route_mask_t routes(0);
+    while(severity_routes != 0)
+    {
+        int const idx(std::countr_zero(severity_routes));
+        route_mask_t const bit(static_cast<route_mask_t>(1) << idx);
+        severity_routes &= ~bit;
+        if((f_routes[idx].f_components & components).any())
+        {
+            routes |= bit;
+        }
+    }
+    return routes;
+}
+
+
+/** \brief Rebuild the routes after an appender changed.
+ *
+ * The appenders call this function when a parameter used to compute
+ * the routes changes: their name, their list of fallbacks, or their
+ * fallback only flag.
+ */
+void logger::appender_changed()
+{
+    guard g;
+
+    publish_config(copy_config());
 }
 
 
@@ -747,31 +1114,62 @@ void logger::add_default_field(std::string const & name, std::string const & val
                   " it cannot be set as a default field.");
         }
 
+        // the snapshot is never modified, we replace it with a new one
+        // so messages referencing the old one are not affected
+        //
         guard g;
 
-        f_default_fields[name] = value;
+        std::shared_ptr<field_list> fields(std::make_shared<field_list>());
+        field_list::pointer_t current(f_default_fields.load());
+        if(current != nullptr)
+        {
+            *fields = *current;
+        }
+
+        // default fields are few and long lived, interning their names
+        // lets ${field:name=...} find them by pointer
+        //
+        fields->set(intern_field_name(name), value);
+        f_default_fields.store(fields);
     }
 }
 
 
 std::string logger::get_default_field(std::string const & name) const
 {
-    guard g;
-
-    auto it(f_default_fields.find(name));
-    if(it != f_default_fields.end())
+    field_list::pointer_t fields(f_default_fields.load());
+    if(fields == nullptr)
     {
-        return it->second;
+        return std::string();
     }
-    return std::string();
+    return fields->get(name);
 }
 
 
 field_map_t logger::get_default_fields() const
 {
-    guard g;
+    field_list::pointer_t fields(f_default_fields.load());
+    if(fields == nullptr)
+    {
+        return field_map_t();
+    }
+    return fields->to_map();
+}
+
 
-    return f_default_fields;
+/** \brief Get the current snapshot of the default fields.
+ *
+ * The snapshot is immutable. Each call to add_default_field() or
+ * remove_default_field() publishes a new one. Messages keep a pointer
+ * to the snapshot which was current when they were created so the
+ * default fields cost nothing per message.
+ *
+ * \return The default fields snapshot or a null pointer if none were
+ * defined.
+ */
+field_list::pointer_t logger::get_default_field_list() const
+{
+    return f_default_fields.load();
 }
 
 
@@ -779,19 +1177,22 @@ void logger::remove_default_field(std::string const & name)
 {
     guard g;
 
-    auto it(f_default_fields.find(name));
-    if(it != f_default_fields.end())
+    field_list::pointer_t current(f_default_fields.load());
+    if(current == nullptr
+    || current->find(name) == nullptr)
     {
-        f_default_fields.erase(it);
+        return;
     }
+
+    std::shared_ptr<field_list> fields(std::make_shared<field_list>(*current));
+    fields->remove(name);
+    f_default_fields.store(fields);
 }
 
 
 bool logger::is_asynchronous() const
 {
-    guard g;
-
-    return f_asynchronous;
+    return f_asynchronous.load(std::memory_order_relaxed);
 }
 
 
@@ -806,6 +1207,7 @@ void logger::set_asynchronous(bool status)
         if(f_asynchronous != status)
         {
             f_asynchronous = status;
+            detail::g_published_asynchronous.store(status, std::memory_order_relaxed);
             if(!f_asynchronous)
             {
                 do_delete = true;
@@ -831,7 +1233,7 @@ void logger::add_early_message(message const & msg)
 {
     if(f_early_messages.size() < g_maximum_early_messages)
     {
-        message::pointer_t m(std::make_shared<message>(static_cast<std::basic_stringstream<char> const &>(msg), msg));
+        message::pointer_t m(std::make_shared<message>(msg, msg));
         f_early_messages.push_back(m);
     }
 }
@@ -848,21 +1250,41 @@ void logger::add_early_messages(message::list_t & messages)
 
 void logger::log_message(message const & msg)
 {
-    if(const_cast<message &>(msg).tellp() > 0)
+    dispatch_message(msg, message::pointer_t());
+}
+
+
+/** \brief Log the message of a SNAP_LOG_...() statement.
+ *
+ * The \p msg message is not accessed by the caller once this function
+ * returns. In asynchronous mode, it gets sent to the logger thread as
+ * is instead of a copy.
+ *
+ * \param[in] msg  The message to log.
+ */
+void logger::log_message(message::pointer_t msg)
+{
+    dispatch_message(*msg, msg);
+}
+
+
+void logger::dispatch_message(message const & msg, message::pointer_t statement)
+{
+    if(!msg.empty())
     {
-        bool asynchronous(false);
+        // intercept any messages sent before the logger is ready
+        // there should be few but it happens as in the initialization
+        // of the plugins which let us know which plugins get loaded
+        // and that is before we're done with the logger initialization
+        //
+        // also, if we are asked to show a value such as the logger
+        // version it's best if we never output those messages
+        //
+        if(!f_ready.load(std::memory_order_acquire))
         {
             guard g;
 
-            // intercept any messages sent before the logger is ready
-            // there should be few but it happens as in the initialization
-            // of the plugins which let us know which plugins get loaded
-            // and that is before we're done with the logger initialization
-            //
-            // also, if we are asked to show a value such as the logger
-            // version it's best if we never output those messages
-            //
-            if(!f_ready)
+            if(!f_ready.load(std::memory_order_relaxed))
             {
                 // the ready() function should be called way before you get
                 // 100 log messages; actually, it should be just 2 for the
@@ -875,17 +1297,23 @@ void logger::log_message(message const & msg)
                 add_early_message(msg);
                 return;
             }
+        }
 
-            if(f_asynchronous)
+        if(f_asynchronous.load(std::memory_order_relaxed))
+        {
+            message::pointer_t m(statement);
+            if(m != nullptr)
             {
-                message::pointer_t m(std::make_shared<message>(msg, msg));
-                private_logger * l(dynamic_cast<private_logger *>(this));
-                l->send_message_to_thread(m);
-                asynchronous = true;
+                m->detach_from_thread();
             }
+            else
+            {
+                m = copy_message(msg);
+            }
+            private_logger * l(dynamic_cast<private_logger *>(this));
+            l->send_message_to_thread(m);
         }
-
-        if(!asynchronous)
+        else
         {
             process_message(msg);
         }
@@ -904,7 +1332,7 @@ void logger::process_message(message const & msg)
 {
     if(!f_early_messages.empty())
     {
-        if(msg.get_components().contains(g_banner_component))
+        if(msg.has_component(g_banner_component))
         {
             add_early_message(msg);
             return;
@@ -922,86 +1350,73 @@ void logger::process_message(message const & msg)
 
 void logger::append_message(message const & msg)
 {
-    appender::vector_t appenders;
+    config_snapshot::pointer_t config(get_config());
 
+    component::mask_t const & components(msg.get_component_mask());
+    if(config->is_filtered_out(components))
     {
-        guard g;
+        return;
+    }
 
-        bool include(f_components_to_include.empty());
-        component::set_t const & components(msg.get_components());
-        if(components.empty())
-        {
-            if(f_components_to_ignore.find(f_normal_component) != f_components_to_ignore.end())
-            {
-                return;
-            }
-            if(!include)
-            {
-                if(f_components_to_include.find(f_normal_component) != f_components_to_include.end())
-                {
-                    include = true;
-                }
-            }
-        }
-        else
+    if(config->f_appenders.empty())
+    {
         {
-            for(auto c : components)
+            guard g;
+
+            if(get_config()->f_appenders.empty())
             {
-                if(f_components_to_ignore.find(c) != f_components_to_ignore.end())
+                if(isatty(fileno(stderr))
+                || isatty(fileno(stdout)))
                 {
-                    return;
+                    add_console_appender();
                 }
-                if(!include)
+                else
                 {
-                    if(f_components_to_include.find(c) != f_components_to_include.end())
-                    {
-                        include = true;
-                    }
+                    add_syslog_appender(std::string());
                 }
             }
         }
-        if(!include)
-        {
-            return;
-        }
+        config = get_config();
+    }
+
+    f_severity_stats[static_cast<std::size_t>(msg.get_severity())].fetch_add(1, std::memory_order_relaxed);
 
-        if(f_appenders.empty())
+    // without a routing table (too many appenders), each appender checks
+    // the severity and components of the message itself
+    //
+    config_snapshot::route_mask_t routes(0);
+    if(config->f_use_routing_table)
+    {
+        routes = config->get_routes(msg.get_severity(), components);
+        if(routes == 0)
         {
-            if(isatty(fileno(stderr))
-            || isatty(fileno(stdout)))
-            {
-                add_console_appender();
-            }
-            else
-            {
-                add_syslog_appender(std::string());
-            }
+            return;
         }
-
-        ++f_severity_stats[static_cast<std::size_t>(msg.get_severity())];
-
-        appenders = f_appenders;
     }
 
-    appender::set_t processed;
-    for(auto a : appenders)
+    // make sure each appender is sent the message only once, including
+    // when it is used as a fallback
+    //
+    processed_appenders processed(config->f_targets.size());
+    std::size_t const max(config->f_routes.size());
+    for(std::size_t idx(0); idx < max; ++idx)
     {
-        // appender created just as a fallback?
-        //
-        if(a->is_fallback_only())
+        if(!processed.insert(idx))
         {
             continue;
         }
 
-        // make sure each appender is sent the message only once
-        //
-        auto result(processed.insert(a));
-        if(!result.second)
+        config_snapshot::route_t const & route(config->f_routes[idx]);
+        bool sent(true);
+        if(!config->f_use_routing_table)
         {
-            continue;
+            sent = route.f_appender->send_message(msg);
         }
-
-        if(a->send_message(msg))
+        else if((routes & (static_cast<config_snapshot::route_mask_t>(1) << idx)) != 0)
+        {
+            sent = route.f_appender->send_routed_message(msg);
+        }
+        if(sent)
         {
             // it worked, just go on with the next appender
             //
@@ -1010,22 +1425,9 @@ void logger::append_message(message const & msg)
 
         // this appender failed, try its fallbacks
         //
-        advgetopt::string_list_t const fallback_appenders(a->get_fallback_appenders());
-        for(auto const & name : fallback_appenders)
+        for(auto const f : route.f_fallbacks)
         {
-            appender::pointer_t f(get_appender(name));
-            if(f == nullptr)
-            {
-                // could not find that appender, ignore error
-                //
-                continue;
-            }
-
-            // just like with the main list, we want to make sure we
-            // only call the appender once per message
-            //
-            result = processed.insert(f);
-            if(!result.second)
+            if(!processed.insert(f))
             {
                 // since the message was sent to that appender (or
                 // some appender fallback) then we consider that we
@@ -1034,7 +1436,7 @@ void logger::append_message(message const & msg)
                 break;
             }
 
-            if(f->send_message(msg))
+            if(config->f_targets[f]->send_message(msg))
             {
                 // exit the loop immediately once we found one
                 // working fallback
@@ -1048,7 +1450,10 @@ void logger::append_message(message const & msg)
 
 void logger::set_fatal_error_severity(severity_t sev)
 {
+    guard g;
+
     f_fatal_severity = sev;
+    publish_lowest_severity();
 }
 
 
@@ -1088,9 +1493,13 @@ void logger::call_fatal_error_callback()
  */
 severity_stats_t logger::get_severity_stats() const
 {
-    guard g;
-
-    return f_severity_stats;
+    severity_stats_t result;
+    result.reserve(f_severity_stats.size());
+    for(auto const & count : f_severity_stats)
+    {
+        result.push_back(count.load(std::memory_order_relaxed));
+    }
+    return result;
 }
 
 
@@ -1102,40 +1511,37 @@ void logger::set_hide_if_banner_only(bool hide)
 
 bool is_configured()
 {
-    guard g;
-
-    if(g_instance == nullptr)
+    logger::pointer_t * instance(g_instance.load(std::memory_order_acquire));
+    if(instance == nullptr)
     {
         return false;
     }
 
-    return (*g_instance)->is_configured();
+    return (*instance)->is_configured();
 }
 
 
 bool has_appender(std::string const & type)
 {
-    guard g;
-
-    if(g_instance == nullptr)
+    logger::pointer_t * instance(g_instance.load(std::memory_order_acquire));
+    if(instance == nullptr)
     {
         return false;
     }
 
-    return (*g_instance)->has_appender(type);
+    return (*instance)->has_appender(type);
 }
 
 
 void reopen()
 {
-    guard g;
-
-    if(g_instance == nullptr)
+    logger::pointer_t * instance(g_instance.load(std::memory_order_acquire));
+    if(instance == nullptr)
     {
         return;
     }
 
-    (*g_instance)->reopen();
+    (*instance)->reopen();
 }
 
 
@@ -1196,7 +1602,7 @@ void mark_ready()
     {
         guard g;
 
-        if(g_instance == nullptr
+        if(g_instance.load() == nullptr
         && !g_first_instance)
         {
             return;
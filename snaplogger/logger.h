@@ -41,6 +41,11 @@
 #include    <serverplugins/collection.h>
 
 
+// C++
+//
+#include    <array>
+
+
 
 namespace snaplogger
 {
@@ -91,6 +96,7 @@ public:
     void                        set_fatal_severity(severity_t severity_level);
     void                        reduce_severity(severity_t severity_level);
     void                        severity_changed(severity_t severity_level);
+    void                        appender_changed();
     severity_t                  get_default_severity() const;
     bool                        set_default_severity(severity_t severity_level);
 
@@ -103,6 +109,7 @@ public:
     void                        add_default_field(std::string const & name, std::string const & value);
     std::string                 get_default_field(std::string const & name) const;
     field_map_t                 get_default_fields() const;
+    field_list::pointer_t       get_default_field_list() const;
     void                        remove_default_field(std::string const & name);
 
     bool                        is_asynchronous() const;
@@ -111,6 +118,7 @@ public:
     void                        add_early_message(message const & msg);
     void                        add_early_messages(message::list_t & messages);
     void                        log_message(message const & msg);
+    void                        log_message(message::pointer_t msg);
     void                        process_message(message const & msg);
     void                        set_fatal_error_severity(severity_t sev);
     void                        set_fatal_error_callback(std::function<void(void)> & f);
@@ -128,21 +136,81 @@ private:
 
     logger &                    operator = (logger const & rhs) = delete;
 
+    /** \brief The configuration used to send messages to the appenders.
+     *
+     * A snapshot is never modified once published. The functions changing
+     * the configuration copy the current snapshot, modify the copy, and
+     * publish it while holding the guard. The functions sending messages
+     * only load the current snapshot, without locking.
+     */
+    struct config_snapshot
+    {
+        typedef std::shared_ptr<config_snapshot const>  pointer_t;
+        typedef std::uint64_t                           route_mask_t;
+
+        static constexpr std::size_t    MAX_ROUTING_TABLE_ROUTES = 64;
+
+        /** \brief An appender messages get sent to.
+         *
+         * The fallbacks are indexes in the f_targets vector. They are
+         * tried in order when the appender fails.
+         *
+         * The components are a copy of the appender mask of components
+         * taken when the routes were built.
+         */
+        struct route_t
+        {
+            appender::pointer_t         f_appender = appender::pointer_t();
+            std::vector<std::size_t>    f_fallbacks = std::vector<std::size_t>();
+            component::mask_t           f_components = component::mask_t();
+        };
+
+        void                    build_routes(component::pointer_t normal_component);
+        bool                    is_filtered_out(component::mask_t const & components) const;
+        route_mask_t            get_routes(severity_t sev, component::mask_t const & components) const;
+
+        appender::vector_t      f_appenders = appender::vector_t();
+        component::mask_t       f_components_to_include = component::mask_t();
+        component::mask_t       f_components_to_ignore = component::mask_t();
+
+        // computed by build_routes(): the first f_routes.size() targets
+        // are the appenders of the routes, the others are fallback only
+        //
+        std::vector<route_t>    f_routes = std::vector<route_t>();
+        appender::vector_t      f_targets = appender::vector_t();
+
+        // the routing table, where bit N represents f_routes[N]; it is
+        // only used when there are at most MAX_ROUTING_TABLE_ROUTES routes
+        //
+        bool                    f_use_routing_table = true;
+        std::array<route_mask_t, static_cast<std::size_t>(severity_t::SEVERITY_MAX) + 1>
+                                f_severity_routes = {};
+        route_mask_t            f_no_component_routes = 0;
+        component::mask_t       f_normal_component = component::mask_t();
+    };
+
+    void                        dispatch_message(message const & msg, message::pointer_t statement);
     void                        append_message(message const & msg);
-
-    appender::vector_t          f_appenders = appender::vector_t();
-    component::set_t            f_components_to_include = component::set_t();
-    component::set_t            f_components_to_ignore = component::set_t();
-    field_map_t                 f_default_fields = field_map_t();
+    void                        publish_lowest_severity();
+    config_snapshot::pointer_t  get_config() const;
+    std::shared_ptr<config_snapshot>
+                                copy_config() const;
+    void                        publish_config(std::shared_ptr<config_snapshot> config);
+
+    std::atomic<config_snapshot::pointer_t>
+                                f_config = config_snapshot::pointer_t();
+    std::atomic<field_list::pointer_t>
+                                f_default_fields = field_list::pointer_t();
     severity_t                  f_lowest_severity = severity_t::SEVERITY_OFF;
     severity_array_t            f_lowest_replacements = severity_array_t();
     severity_t                  f_fatal_severity = severity_t::SEVERITY_OFF;
     std::function<void(void)>   f_fatal_error_callback = nullptr;
     message::list_t             f_early_messages = message::list_t();
-    bool                        f_ready = false;
+    std::atomic<bool>           f_ready = false;
     bool                        f_hide_if_banner_only = true;
-    bool                        f_asynchronous = false;
-    severity_stats_t            f_severity_stats = severity_stats_t(static_cast<std::size_t>(severity_t::SEVERITY_MAX) - static_cast<std::size_t>(severity_t::SEVERITY_MIN) + 1);
+    std::atomic<bool>           f_asynchronous = false;
+    std::vector<std::atomic<std::size_t>>
+                                f_severity_stats = std::vector<std::atomic<std::size_t>>(static_cast<std::size_t>(severity_t::SEVERITY_MAX) - static_cast<std::size_t>(severity_t::SEVERITY_MIN) + 1);
     serverplugins::collection::pointer_t
                                 f_plugins = serverplugins::collection::pointer_t();
 };
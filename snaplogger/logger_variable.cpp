@@ -55,34 +55,69 @@ namespace
 
 
 
-DEFINE_LOGGER_VARIABLE(severity)
+enum class severity_format_t
 {
-    enum class format_t
+    SEVERITY_FORMAT_ALPHA,
+    SEVERITY_FORMAT_NUMBER,
+    SEVERITY_FORMAT_SYSTEMD,
+};
+
+
+DEFINE_COMPILED_LOGGER_VARIABLE(severity, severity_format_t)
+{
+    severity_t sev(msg.get_severity());
+    switch(f_plan)
     {
-        FORMAT_ALPHA,
-        FORMAT_NUMBER,
-        FORMAT_SYSTEMD,
-    };
+    case severity_format_t::SEVERITY_FORMAT_ALPHA:
+        {
+            severity_table_pointer_t const table(get_severity_table(msg));
+            severity_entry const & entry((*table)[static_cast<std::size_t>(sev)]);
+            if(entry.f_severity != nullptr)
+            {
+                value += entry.f_description;
+                break;
+            }
+        }
+        [[fallthrough]];
+    case severity_format_t::SEVERITY_FORMAT_NUMBER:
+        value += std::to_string(static_cast<int>(sev));
+        break;
 
-    format_t format(format_t::FORMAT_ALPHA);
+    case severity_format_t::SEVERITY_FORMAT_SYSTEMD:
+        // see https://www.freedesktop.org/software/systemd/man/sd-daemon.html
+        //
+        value += '<';
+        value += std::to_string(syslog_appender::message_severity_to_syslog_priority(sev));
+        value += '>';
+        break;
+
+    }
 
-    auto params(get_params());
+    variable::process_value(msg, value);
+}
+
+
+COMPILE_LOGGER_VARIABLE(severity)
+{
+    f_plan = severity_format_t::SEVERITY_FORMAT_ALPHA;
+
+    auto const & params(get_params());
     if(!params.empty())
     {
         if(params[0]->get_name() == "format")
         {
-            auto v(params[0]->get_value());
+            auto const & v(params[0]->get_value());
             if(v == "alpha")
             {
-                format = format_t::FORMAT_ALPHA;
+                f_plan = severity_format_t::SEVERITY_FORMAT_ALPHA;
             }
             else if(v == "number")
             {
-                format = format_t::FORMAT_NUMBER;
+                f_plan = severity_format_t::SEVERITY_FORMAT_NUMBER;
             }
             else if(v == "systemd")
             {
-                format = format_t::FORMAT_SYSTEMD;
+                f_plan = severity_format_t::SEVERITY_FORMAT_SYSTEMD;
             }
             else
             {
@@ -93,35 +128,6 @@ DEFINE_LOGGER_VARIABLE(severity)
             }
         }
     }
-
-    severity_t sev(msg.get_severity());
-    switch(format)
-    {
-    case format_t::FORMAT_ALPHA:
-        {
-            severity::pointer_t severity(get_severity(msg, sev));
-            if(severity != nullptr)
-            {
-                value += severity->get_description();
-                break;
-            }
-        }
-        [[fallthrough]];
-    case format_t::FORMAT_NUMBER:
-        value += std::to_string(static_cast<int>(sev));
-        break;
-
-    case format_t::FORMAT_SYSTEMD:
-        // see https://www.freedesktop.org/software/systemd/man/sd-daemon.html
-        //
-        value += '<';
-        value += std::to_string(syslog_appender::message_severity_to_syslog_priority(sev));
-        value += '>';
-        break;
-
-    }
-
-    variable::process_value(msg, value);
 }
 
 
@@ -143,7 +149,7 @@ DEFINE_LOGGER_VARIABLE(message)
     {
         msg.set_recursive_message(true);
         format f(m);
-        value += f.process_message(msg);
+        f.process_message(msg, value);
         msg.set_recursive_message(false);
     }
 
@@ -152,24 +158,62 @@ DEFINE_LOGGER_VARIABLE(message)
 
 
 
-DEFINE_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(field)
+/** \brief The field a ${field:name=...} variable outputs.
+ *
+ * User field names are interned so the lookup only compares pointers.
+ * System field names (which start with an underscore) are converted to
+ * their system_field_t.
+ */
+struct field_plan
+{
+    std::string const * f_name = nullptr;
+    system_field_t      f_system_field = system_field_t::SYSTEM_FIELD_UNDEFINED;
+};
+
+
+DEFINE_COMPILED_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(field, field_plan)
+{
+    if(f_plan.f_name != nullptr)
+    {
+        value += msg.get_field(f_plan.f_name);
+    }
+    else if(f_plan.f_system_field != system_field_t::SYSTEM_FIELD_UNDEFINED)
+    {
+        value += msg.get_field(f_plan.f_system_field);
+    }
+
+    variable::process_value(msg, value);
+}
+
+
+COMPILE_LOGGER_VARIABLE(field)
 {
-    auto params(get_params());
+    f_plan = field_plan();
+
+    auto const & params(get_params());
     if(!params.empty())
     {
         if(params[0]->get_name() == "name")
         {
-            auto name(params[0]->get_value());
-            value += msg.get_field(name);
+            std::string const & name(params[0]->get_value());
+            if(!name.empty()
+            && name[0] == '_')
+            {
+                f_plan.f_system_field = message::get_system_field_from_name(name);
+            }
+            else
+            {
+                f_plan.f_name = intern_field_name(name);
+            }
         }
     }
-
-    variable::process_value(msg, value);
 }
 
 
 
-DEFINE_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(fields)
+/** \brief The output settings of the ${fields} variable.
+ */
+struct fields_plan
 {
     enum class format_t
     {
@@ -183,53 +227,18 @@ DEFINE_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(fields)
         OBJECT
     };
 
-    format_t format(format_t::FORMAT_JSON);
-    json_t json(json_t::OBJECT);
+    format_t            f_format = format_t::FORMAT_JSON;
+    json_t              f_json = json_t::OBJECT;
+};
 
-    for(auto const & p : get_params())
-    {
-        auto const v(p->get_value());
-        if(p->get_name() == "format")
-        {
-            if(v == "json")
-            {
-                format = format_t::FORMAT_JSON;
-            }
-            else if(v == "shell")
-            {
-                format = format_t::FORMAT_SHELL;
-            }
-            else
-            {
-                throw invalid_variable(
-                              "the ${fields:format=json|shell} variable cannot be set to \""
-                            + v
-                            + "\".");
-            }
-        }
-        else if(p->get_name() == "json")
-        {
-            if(v == "start_comma")
-            {
-                json = json_t::START_COMMA;
-            }
-            else if(v == "end_comma")
-            {
-                json = json_t::END_COMMA;
-            }
-            else if(v == "object")
-            {
-                json = json_t::OBJECT;
-            }
-            else
-            {
-                throw invalid_variable(
-                              "the ${fields:json=start_comma|end_comma|object} variable cannot be set to \""
-                            + v
-                            + "\".");
-            }
-        }
-    }
+
+DEFINE_COMPILED_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(fields, fields_plan)
+{
+    typedef fields_plan::format_t format_t;
+    typedef fields_plan::json_t json_t;
+
+    format_t const format(f_plan.f_format);
+    json_t const json(f_plan.f_json);
 
     int start_comma(0);
     switch(format)
@@ -297,17 +306,69 @@ DEFINE_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(fields)
 }
 
 
+COMPILE_LOGGER_VARIABLE(fields)
+{
+    f_plan = fields_plan();
+
+    for(auto const & p : get_params())
+    {
+        if(p->get_name() == "format")
+        {
+            auto const & v(p->get_value());
+            if(v == "json")
+            {
+                f_plan.f_format = fields_plan::format_t::FORMAT_JSON;
+            }
+            else if(v == "shell")
+            {
+                f_plan.f_format = fields_plan::format_t::FORMAT_SHELL;
+            }
+            else
+            {
+                throw invalid_variable(
+                              "the ${fields:format=json|shell} variable cannot be set to \""
+                            + v
+                            + "\".");
+            }
+        }
+        else if(p->get_name() == "json")
+        {
+            auto const & v(p->get_value());
+            if(v == "start_comma")
+            {
+                f_plan.f_json = fields_plan::json_t::START_COMMA;
+            }
+            else if(v == "end_comma")
+            {
+                f_plan.f_json = fields_plan::json_t::END_COMMA;
+            }
+            else if(v == "object")
+            {
+                f_plan.f_json = fields_plan::json_t::OBJECT;
+            }
+            else
+            {
+                throw invalid_variable(
+                              "the ${fields:json=start_comma|end_comma|object} variable cannot be set to \""
+                            + v
+                            + "\".");
+            }
+        }
+    }
+}
+
+
 
 DEFINE_LOGGER_VARIABLE(project_name)
 {
     // when the advgetopt is properly connected to the logger, then the
     // logger will save the project name in its diagnostic map
     //
-    map_diagnostics_t map(get_map_diagnostics(msg));
-    auto it(map.find(DIAG_KEY_PROJECT_NAME));
-    if(it != map.end())
+    map_diagnostics_pointer_t const diagnostics(get_map_diagnostics_snapshot(msg));
+    std::string const * diagnostic(find_diagnostic(msg, *diagnostics, DIAG_KEY_PROJECT_NAME));
+    if(diagnostic != nullptr)
     {
-        value += it->second;
+        value += *diagnostic;
     }
 
     variable::process_value(msg, value);
@@ -320,11 +381,11 @@ DEFINE_LOGGER_VARIABLE(progname)
     // when the advgetopt is properly connected to the logger, then the
     // logger will save the program name in its diagnostic map
     //
-    map_diagnostics_t map(get_map_diagnostics(msg));
-    auto it(map.find(DIAG_KEY_PROGNAME));
-    if(it != map.end())
+    map_diagnostics_pointer_t const diagnostics(get_map_diagnostics_snapshot(msg));
+    std::string const * diagnostic(find_diagnostic(msg, *diagnostics, DIAG_KEY_PROGNAME));
+    if(diagnostic != nullptr)
     {
-        value += it->second;
+        value += *diagnostic;
     }
 
     variable::process_value(msg, value);
@@ -337,11 +398,11 @@ DEFINE_LOGGER_VARIABLE(version)
     // when the advgetopt is properly connected to the logger, then the
     // logger will save the program version in its diagnostic map
     //
-    map_diagnostics_t map(get_map_diagnostics(msg));
-    auto it(map.find(DIAG_KEY_VERSION));
-    if(it != map.end())
+    map_diagnostics_pointer_t const diagnostics(get_map_diagnostics_snapshot(msg));
+    std::string const * diagnostic(find_diagnostic(msg, *diagnostics, DIAG_KEY_VERSION));
+    if(diagnostic != nullptr)
     {
-        value += it->second;
+        value += *diagnostic;
     }
 
     variable::process_value(msg, value);
@@ -351,11 +412,11 @@ DEFINE_LOGGER_VARIABLE(version)
 
 DEFINE_LOGGER_VARIABLE(build_date)
 {
-    map_diagnostics_t map(get_map_diagnostics(msg));
-    auto it(map.find(DIAG_KEY_BUILD_DATE));
-    if(it != map.end())
+    map_diagnostics_pointer_t const diagnostics(get_map_diagnostics_snapshot(msg));
+    std::string const * diagnostic(find_diagnostic(msg, *diagnostics, DIAG_KEY_BUILD_DATE));
+    if(diagnostic != nullptr)
     {
-        value += it->second;
+        value += *diagnostic;
     }
 
     variable::process_value(msg, value);
@@ -365,11 +426,11 @@ DEFINE_LOGGER_VARIABLE(build_date)
 
 DEFINE_LOGGER_VARIABLE(build_time)
 {
-    map_diagnostics_t map(get_map_diagnostics(msg));
-    auto it(map.find(DIAG_KEY_BUILD_TIME));
-    if(it != map.end())
+    map_diagnostics_pointer_t const diagnostics(get_map_diagnostics_snapshot(msg));
+    std::string const * diagnostic(find_diagnostic(msg, *diagnostics, DIAG_KEY_BUILD_TIME));
+    if(diagnostic != nullptr)
     {
-        value += it->second;
+        value += *diagnostic;
     }
 
     variable::process_value(msg, value);
@@ -388,9 +449,9 @@ DEFINE_LOGGER_VARIABLE(filename)
 
 DEFINE_LOGGER_VARIABLE(basename)
 {
-    std::string const filename(msg.get_filename());
-    std::string::size_type const pos(filename.rfind('/'));
-    if(pos == std::string::npos)
+    std::string_view const filename(msg.get_filename());
+    std::string_view::size_type const pos(filename.rfind('/'));
+    if(pos == std::string_view::npos)
     {
         value += filename;
     }
@@ -406,9 +467,9 @@ DEFINE_LOGGER_VARIABLE(basename)
 
 DEFINE_LOGGER_VARIABLE(path)
 {
-    std::string const filename(msg.get_filename());
-    std::string::size_type const pos(filename.rfind('/'));
-    if(pos != std::string::npos)
+    std::string_view const filename(msg.get_filename());
+    std::string_view::size_type const pos(filename.rfind('/'));
+    if(pos != std::string_view::npos)
     {
         value += filename.substr(0, pos);
     }
@@ -436,53 +497,37 @@ DEFINE_LOGGER_VARIABLE(line)
 
 
 
-DEFINE_LOGGER_VARIABLE(diagnostic)
+/** \brief The diagnostics output by a ${diagnostic} variable.
+ */
+struct diagnostic_plan
 {
-    constexpr int FLAG_NESTED = 0x01;
-    constexpr int FLAG_MAP    = 0x02;
-    constexpr int FLAG_TRACE  = 0x04;
+    static constexpr int FLAG_NESTED = 0x01;
+    static constexpr int FLAG_MAP    = 0x02;
+    static constexpr int FLAG_TRACE  = 0x04;
 
-    std::int64_t nested_depth(-1);
-    std::int64_t trace_count(-1);
-    std::string key;
-    int flags(0);
+    int                 f_flags = 0;
+    std::int64_t        f_nested_depth = -1;
+    std::int64_t        f_trace_count = -1;
+    std::string         f_key = std::string();
+};
 
-    for(auto const & p : get_params())
-    {
-        if(p->get_name() == "nested")
-        {
-            flags |= FLAG_NESTED;
 
-            // the integer is optional
-            //
-            if(!p->empty())
-            {
-                nested_depth = p->get_integer();
-            }
-        }
-        else if(p->get_name() == "map")
-        {
-            flags |= FLAG_MAP;
-            key = p->get_value();
-        }
-        else if(p->get_name() == "trace")
-        {
-            flags |= FLAG_TRACE;
+DEFINE_COMPILED_LOGGER_VARIABLE(diagnostic, diagnostic_plan)
+{
+    constexpr int FLAG_NESTED = diagnostic_plan::FLAG_NESTED;
+    constexpr int FLAG_MAP    = diagnostic_plan::FLAG_MAP;
+    constexpr int FLAG_TRACE  = diagnostic_plan::FLAG_TRACE;
 
-            // the integer is optional
-            //
-            if(!p->empty())
-            {
-                trace_count = p->get_integer();
-            }
-        }
-    }
+    std::int64_t const nested_depth(f_plan.f_nested_depth);
+    std::int64_t const trace_count(f_plan.f_trace_count);
+    std::string const & key(f_plan.f_key);
+    int const flags(f_plan.f_flags);
 
     if(flags == 0
     || (flags & FLAG_NESTED) != 0)
     {
         char sep('{');
-        string_vector_t nested(get_nested_diagnostics(msg));
+        string_vector_t const & nested(msg.get_nested_diagnostics());
         size_t idx(0);
         if((flags & FLAG_NESTED) != 0
         && nested_depth != -1
@@ -535,13 +580,23 @@ DEFINE_LOGGER_VARIABLE(diagnostic)
     if(flags == 0
     || (flags & FLAG_MAP) != 0)
     {
-        auto const diagnostics(get_map_diagnostics(msg));
-        if(!diagnostics.empty())
+        map_diagnostics_pointer_t const global(get_map_diagnostics_snapshot(msg));
+        if(key.empty())
         {
-            if(key.empty())
+            // the context diagnostics must be merged with the global ones
+            // to list them in order; that requires a copy
+            //
+            map_diagnostics_t merged;
+            map_diagnostics_t const * diagnostics(global.get());
+            if(!msg.get_context_diagnostics().empty())
+            {
+                merged = get_map_diagnostics(msg);
+                diagnostics = &merged;
+            }
+            if(!diagnostics->empty())
             {
                 char sep('<');
-                for(auto d : diagnostics)
+                for(auto const & d : *diagnostics)
                 {
                     value += sep;
                     sep = ':';
@@ -551,17 +606,17 @@ DEFINE_LOGGER_VARIABLE(diagnostic)
                 }
                 value += '>';
             }
-            else
+        }
+        else
+        {
+            std::string const * diagnostic(find_diagnostic(msg, *global, key));
+            if(diagnostic != nullptr)
             {
-                auto it(diagnostics.find(key));
-                if(it != diagnostics.end())
-                {
-                    value += '<';
-                    value += key;
-                    value += '=';
-                    value += it->second;
-                    value += '>';
-                }
+                value += '<';
+                value += key;
+                value += '=';
+                value += *diagnostic;
+                value += '>';
             }
         }
     }
@@ -570,17 +625,57 @@ DEFINE_LOGGER_VARIABLE(diagnostic)
 }
 
 
+COMPILE_LOGGER_VARIABLE(diagnostic)
+{
+    f_plan = diagnostic_plan();
+
+    for(auto const & p : get_params())
+    {
+        if(p->get_name() == "nested")
+        {
+            f_plan.f_flags |= diagnostic_plan::FLAG_NESTED;
+
+            // the integer is optional
+            //
+            if(!p->empty())
+            {
+                f_plan.f_nested_depth = p->get_integer();
+            }
+        }
+        else if(p->get_name() == "map")
+        {
+            f_plan.f_flags |= diagnostic_plan::FLAG_MAP;
+            f_plan.f_key = p->get_value();
+        }
+        else if(p->get_name() == "trace")
+        {
+            f_plan.f_flags |= diagnostic_plan::FLAG_TRACE;
+
+            // the integer is optional
+            //
+            if(!p->empty())
+            {
+                f_plan.f_trace_count = p->get_integer();
+            }
+        }
+    }
+}
+
+
 DEFINE_LOGGER_VARIABLE(components)
 {
-    component::set_t const & components(msg.get_components());
-    if(!components.empty())
+    component::mask_t const & components(msg.get_component_mask());
+    if(components.any())
     {
         char sep('[');
-        for(auto c : components)
+        for(std::size_t idx(0); idx < components.size(); ++idx)
         {
-            value += sep;
-            sep = ',';
-            value += c->get_name();
+            if(components.test(idx))
+            {
+                value += sep;
+                sep = ',';
+                value += get_component_by_index(idx)->get_name();
+            }
         }
         value += ']';
 
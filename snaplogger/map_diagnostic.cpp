@@ -40,6 +40,25 @@ namespace snaplogger
 {
 
 
+namespace
+{
+
+
+
+/** \brief The context diagnostics of the current thread.
+ *
+ * The scoped_context objects push and pop their key and value here.
+ * The vector keeps its buffer once it grew so short keys and values
+ * (which fit in the std::string small buffer) do not allocate memory.
+ */
+thread_local context_diagnostics_t  g_context_diagnostics = context_diagnostics_t();
+
+
+
+}
+// no name namespace
+
+
 
 void set_diagnostic(std::string const & key, std::string const & diagnostic)
 {
@@ -53,15 +72,140 @@ void unset_diagnostic(std::string const & key)
 }
 
 
+std::string get_diagnostic(std::string const & key)
+{
+    return get_private_logger()->get_diagnostic(key);
+}
+
+
 map_diagnostics_t get_map_diagnostics()
 {
     return get_private_logger()->get_map_diagnostics();
 }
 
 
+/** \brief Get the diagnostics of a message.
+ *
+ * This function returns the global diagnostics overwritten by the context
+ * diagnostics of the message. The context diagnostics are those of the
+ * thread which created the message (see scoped_context).
+ *
+ * \param[in] msg  The message for which the diagnostics are returned.
+ *
+ * \return The map of diagnostics.
+ */
 map_diagnostics_t get_map_diagnostics(message const & msg)
 {
-    return get_private_logger(msg)->get_map_diagnostics();
+    map_diagnostics_t result(*get_private_logger(msg)->get_map_diagnostics_snapshot());
+    for(auto const & c : msg.get_context_diagnostics())
+    {
+        result[c.first] = c.second;
+    }
+    return result;
+}
+
+
+/** \brief Get the current global diagnostics.
+ *
+ * The map is never modified. Each call to set_diagnostic() or
+ * unset_diagnostic() creates a new map which replaces the previous one.
+ * This function does not lock anything and the returned map remains
+ * valid as long as the pointer is kept.
+ *
+ * The context diagnostics are not included. Use find_diagnostic() to
+ * search both.
+ *
+ * \return A pointer to the global diagnostics.
+ */
+map_diagnostics_pointer_t get_map_diagnostics_snapshot()
+{
+    return get_private_logger()->get_map_diagnostics_snapshot();
+}
+
+
+map_diagnostics_pointer_t get_map_diagnostics_snapshot(message const & msg)
+{
+    return get_private_logger(msg)->get_map_diagnostics_snapshot();
+}
+
+
+/** \brief Search a diagnostic for a message.
+ *
+ * The context diagnostics of the message are searched first, from the
+ * newest to the oldest. If not found there, the function searches the
+ * \p diagnostics map, generally the global diagnostics as returned by
+ * get_map_diagnostics_snapshot().
+ *
+ * \param[in] msg  The message for which the diagnostic is searched.
+ * \param[in] diagnostics  The global diagnostics.
+ * \param[in] key  The name of the diagnostic to search.
+ *
+ * \return A pointer to the value or nullptr if \p key is not defined.
+ */
+std::string const * find_diagnostic(
+      message const & msg
+    , map_diagnostics_t const & diagnostics
+    , std::string const & key)
+{
+    context_diagnostics_t const & context(msg.get_context_diagnostics());
+    for(auto it(context.rbegin()); it != context.rend(); ++it)
+    {
+        if(it->first == key)
+        {
+            return &it->second;
+        }
+    }
+
+    auto const it(diagnostics.find(key));
+    if(it == diagnostics.end())
+    {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+
+/** \brief Add a diagnostic to the context of the current thread.
+ *
+ * The diagnostic is visible in the messages logged by the current thread
+ * until this object gets destroyed. It hides a global diagnostic with
+ * the same key and a context diagnostic with the same key created
+ * earlier.
+ *
+ * This is useful to attach a value such as a request identifier to all
+ * the messages logged while processing that request:
+ *
+ * \code
+ *     snaplogger::scoped_context ctx("request_id", id);
+ * \endcode
+ *
+ * Creating and destroying a context does not lock anything.
+ *
+ * \param[in] key  The name of the diagnostic.
+ * \param[in] value  The value of the diagnostic.
+ */
+scoped_context::scoped_context(std::string const & key, std::string const & value)
+{
+    g_context_diagnostics.emplace_back(key, value);
+}
+
+
+scoped_context::~scoped_context()
+{
+    g_context_diagnostics.pop_back();
+}
+
+
+/** \brief Get a reference to the context diagnostics of the current thread.
+ *
+ * The entries are sorted from the oldest to the newest. The reference is
+ * only valid within the calling thread.
+ *
+ * \return A reference to the context diagnostics of the calling thread.
+ */
+context_diagnostics_t const & get_thread_context_diagnostics()
+{
+    return g_context_diagnostics;
 }
 
 
@@ -31,7 +31,11 @@
 
 // C++
 //
+#include    <concepts>
 #include    <map>
+#include    <memory>
+#include    <string>
+#include    <vector>
 
 
 // C
@@ -52,12 +56,44 @@ constexpr char const        DIAG_KEY_BUILD_TIME[]   = "build_time";
 
 
 typedef std::map<std::string, std::string>        map_diagnostics_t;
+typedef std::shared_ptr<map_diagnostics_t const>  map_diagnostics_pointer_t;
 
 void                set_diagnostic(std::string const & key, std::string const & diagnostic);
 void                unset_diagnostic(std::string const & key);
+std::string         get_diagnostic(std::string const & key);
 
 map_diagnostics_t   get_map_diagnostics();
 map_diagnostics_t   get_map_diagnostics(message const & msg);
+map_diagnostics_pointer_t
+                    get_map_diagnostics_snapshot();
+map_diagnostics_pointer_t
+                    get_map_diagnostics_snapshot(message const & msg);
+std::string const * find_diagnostic(
+                          message const & msg
+                        , map_diagnostics_t const & diagnostics
+                        , std::string const & key);
+
+
+class scoped_context
+{
+public:
+                    scoped_context(std::string const & key, std::string const & value);
+                    scoped_context(scoped_context const &) = delete;
+                    ~scoped_context();
+
+    template<std::integral T>
+                    scoped_context(std::string const & key, T value)
+                        : scoped_context(key, std::to_string(value))
+                    {
+                    }
+
+    scoped_context &
+                    operator = (scoped_context const &) = delete;
+};
+
+
+context_diagnostics_t const &
+                    get_thread_context_diagnostics();
 
 
 } // snaplogger namespace
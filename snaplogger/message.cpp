@@ -27,13 +27,17 @@
 // 
 #include    "snaplogger/message.h"
 
+#include    "snaplogger/clock.h"
 #include    "snaplogger/exception.h"
-#include    "snaplogger/guard.h"
 #include    "snaplogger/logger.h"
+#include    "snaplogger/map_diagnostic.h"
+#include    "snaplogger/nested_diagnostic.h"
 
 
 // C++
 //
+#include    <algorithm>
+#include    <atomic>
 #include    <iostream>
 
 
@@ -73,24 +77,152 @@ constexpr char const * const g_system_field_names[] =
 #pragma GCC diagnostic pop
 
 
-std::uint32_t         g_message_id = 0U;
+std::atomic<std::uint32_t>  g_message_id = 0U;
 
 
-std::uint32_t get_next_id()
+/** \brief Maximum number of messages kept in a thread pool.
+ *
+ * In most cases a thread uses one message at a time. With the
+ * asynchronous thread, though, many messages may be waiting in the
+ * FIFO. Once this limit is reached, further messages are allocated
+ * and deleted as usual.
+ */
+constexpr std::size_t const g_maximum_pooled_messages = 64;
+
+
+
+}
+// no name namespace
+
+
+
+namespace detail
 {
-    guard g;
 
-    ++g_message_id;
-    if(g_message_id == 0)
+
+
+/** \brief Allocate a new message identifier.
+ *
+ * Each message receives a unique identifier when created. The counter
+ * is shared by all the threads so identifiers are increasing in the
+ * order the messages get created. The value 0 is never returned.
+ *
+ * \return The new message identifier.
+ */
+std::uint32_t get_next_message_id()
+{
+    // the counter is only used to generate unique identifiers so we do
+    // not need any ordering with other memory accesses
+    //
+    std::uint32_t id(g_message_id.fetch_add(1, std::memory_order_relaxed) + 1);
+    if(id == 0)
     {
         // never use 0 as the id; of course, it's very unlikely that this happens
         //
-        g_message_id = 1;
+        id = g_message_id.fetch_add(1, std::memory_order_relaxed) + 1;
     }
-    return g_message_id;
+    return id;
+}
+
+
+
+/** \brief A pool of messages.
+ *
+ * Creating a message requires many allocations (the message itself,
+ * its stream buffer, its fields, etc.) Each thread has its own pool
+ * of messages which get reused once released.
+ *
+ * A message is considered released once the pool holds the only
+ * reference to it. Since the pool is local to a thread, no other thread
+ * can acquire a new reference to such a message, which makes it safe to
+ * reuse even if the last reference was released by another thread.
+ */
+class message_pool
+{
+public:
+    template<typename T>
+    message::pointer_t get(severity_t sev, T const & location)
+    {
+        message::pointer_t msg(find_available());
+        if(msg == nullptr)
+        {
+            msg = std::make_shared<message>(sev, location);
+            add(msg);
+        }
+        else
+        {
+            msg->reset(sev, location);
+        }
+        return msg;
+    }
+
+    message::pointer_t get_statement(severity_t sev, call_site const & site)
+    {
+        message::pointer_t msg(get(sev, site));
+        msg->f_statement = true;
+        return msg;
+    }
+
+    message::pointer_t copy(message const & rhs)
+    {
+        message::pointer_t msg(find_available());
+        if(msg == nullptr)
+        {
+            msg = std::make_shared<message>(rhs, rhs);
+            add(msg);
+        }
+        else
+        {
+            msg->copy(rhs);
+        }
+        return msg;
+    }
+
+private:
+    message::pointer_t find_available()
+    {
+        std::size_t const max(f_messages.size());
+        for(std::size_t count(0); count < max; ++count)
+        {
+            message::pointer_t const & msg(f_messages[f_next]);
+            f_next = (f_next + 1) % max;
+            if(msg.use_count() == 1)
+            {
+                // make sure we see all the changes made by the thread
+                // which released that message
+                //
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return msg;
+            }
+        }
+        return message::pointer_t();
+    }
+
+    void add(message::pointer_t msg)
+    {
+        if(f_messages.size() < g_maximum_pooled_messages)
+        {
+            f_messages.push_back(msg);
+        }
+    }
+
+    std::vector<message::pointer_t>     f_messages = std::vector<message::pointer_t>();
+    std::size_t                         f_next = 0;
+};
+
+
+
 }
+// detail namespace
+
+
+
+namespace
+{
 
 
+thread_local detail::message_pool   g_message_pool = detail::message_pool();
+
 
 }
 // no name namespace
@@ -107,62 +239,501 @@ int null_buffer::overflow(int c)
 
 
 
+message_buffer::message_buffer()
+{
+    setp(f_inline, f_inline + INLINE_SIZE);
+}
+
+
+message_buffer::~message_buffer()
+{
+    destroy_deferred(f_deferred);
+}
+
+
+bool message_buffer::empty() const
+{
+    return pptr() == pbase()
+        && f_deferred == nullptr;
+}
+
+
+std::size_t message_buffer::size() const
+{
+    return pptr() - pbase();
+}
+
+
+std::string_view message_buffer::view() const
+{
+    return std::string_view(pbase(), size());
+}
+
+
+std::string message_buffer::str() const
+{
+    return std::string(view());
+}
+
+
+/** \brief Empty the buffer.
+ *
+ * This function resets the put pointer to the start of the buffer.
+ * If the message spilled to the heap, that memory is kept so the next
+ * long message does not have to allocate it again.
+ */
+void message_buffer::clear()
+{
+    deferred_message * deferred(f_deferred);
+    f_deferred = nullptr;
+    destroy_deferred(deferred);
+
+    setp(pbase(), storage_end());
+}
+
+
+/** \brief Make sure the next write renders the deferred message.
+ *
+ * The deferred message gets rendered at the current position the next
+ * time something is written to the buffer or when render() is called.
+ * To catch the next write, the end of the put area is moved to the
+ * current position so the stream has to call overflow() or xsputn().
+ */
+void message_buffer::catch_next_write()
+{
+    std::size_t const used(size());
+    setp(pbase(), pptr());
+    pbump(static_cast<int>(used));
+}
+
+
+/** \brief Release a deferred message.
+ *
+ * The deferred message is either constructed in the f_deferred_storage
+ * buffer or, if too large, allocated on the heap. This function calls
+ * the destructor or deletes it accordingly.
+ *
+ * \param[in] deferred  The deferred message to release, may be nullptr.
+ */
+void message_buffer::destroy_deferred(deferred_message * deferred)
+{
+    if(deferred == nullptr)
+    {
+        return;
+    }
+
+    if(static_cast<void *>(deferred) == static_cast<void *>(f_deferred_storage))
+    {
+        deferred->~deferred_message();
+    }
+    else
+    {
+        delete deferred;
+    }
+}
+
+
+/** \brief Render the deferred message, if any.
+ *
+ * This function writes the deferred message at the end of the buffer
+ * and restores the put area so further writes go straight in the buffer.
+ */
+void message_buffer::render()
+{
+    if(f_deferred != nullptr)
+    {
+        deferred_message * deferred(f_deferred);
+        f_deferred = nullptr;
+
+        std::size_t const used(size());
+        setp(pbase(), storage_end());
+        pbump(static_cast<int>(used));
+
+        try
+        {
+            deferred->render(this);
+        }
+        catch(...)
+        {
+            destroy_deferred(deferred);
+            throw;
+        }
+        destroy_deferred(deferred);
+    }
+}
+
+
+/** \brief Render the deferred message in another buffer.
+ *
+ * This function is used to copy a message. The deferred message, if any,
+ * stays attached to this buffer.
+ *
+ * \param[in] out  The buffer receiving the rendered message.
+ */
+void message_buffer::render_deferred(std::streambuf * out) const
+{
+    if(f_deferred != nullptr)
+    {
+        f_deferred->render(out);
+    }
+}
+
+
+int message_buffer::overflow(int c)
+{
+    render();
+
+    if(traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        return traits_type::not_eof(c);
+    }
+
+    if(pptr() == epptr())
+    {
+        grow(1);
+    }
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+
+    return c;
+}
+
+
+std::streamsize message_buffer::xsputn(char const * s, std::streamsize n)
+{
+    if(n <= 0)
+    {
+        return 0;
+    }
+
+    render();
+
+    std::size_t const length(static_cast<std::size_t>(n));
+    if(length > static_cast<std::size_t>(epptr() - pptr()))
+    {
+        grow(length);
+    }
+    traits_type::copy(pptr(), s, length);
+    pbump(static_cast<int>(n));
+
+    return n;
+}
+
+
+/** \brief Support for the tellp() function.
+ *
+ * The buffer is write only and does not support seeking. The only
+ * position available is the current output position which is also the
+ * size of the message.
+ */
+message_buffer::pos_type message_buffer::seekoff(
+      off_type off
+    , std::ios_base::seekdir dir
+    , std::ios_base::openmode which)
+{
+    if(off != 0
+    || dir != std::ios_base::cur
+    || (which & std::ios_base::out) == 0)
+    {
+        return pos_type(off_type(-1));
+    }
+
+    return pos_type(static_cast<off_type>(size()));
+}
+
+
+char * message_buffer::storage_end()
+{
+    if(pbase() == f_inline)
+    {
+        return f_inline + INLINE_SIZE;
+    }
+    return f_spill.data() + f_spill.size();
+}
+
+
+/** \brief Make room for \p extra more characters.
+ *
+ * The first time the inline buffer is too small, the content is moved
+ * to the f_spill string. After that, the string grows by doubling its
+ * size as required.
+ *
+ * \param[in] extra  The number of characters about to be written.
+ */
+void message_buffer::grow(std::size_t extra)
+{
+    std::size_t const used(size());
+    std::size_t const capacity(std::max(
+              (f_spill.empty() ? INLINE_SIZE : f_spill.size()) * 2
+            , used + extra));
+
+    bool const was_inline(pbase() == f_inline);
+    f_spill.resize(capacity);
+    if(was_inline)
+    {
+        traits_type::copy(f_spill.data(), f_inline, used);
+    }
+
+    setp(f_spill.data(), f_spill.data() + f_spill.size());
+    pbump(static_cast<int>(used));
+}
+
+
+
+
+
 message::message(
           severity_t sev
         , std::source_location const & location)
-    : f_logger(logger::get_instance())
-    , f_severity(sev)
-    , f_filename(location.file_name())
-    , f_funcname(location.function_name())
-    , f_line(location.line())
-    , f_column(location.column())
-    , f_environment(create_environment())
-    , f_fields(f_logger->get_default_fields())
+    : std::basic_ostream<char>(nullptr)
+    , f_logger(logger::get_instance())
 {
-    clock_gettime(CLOCK_REALTIME_COARSE, &f_timestamp);
+    rdbuf(&f_buffer);
+    reset(sev, location);
+}
 
-    add_field("id", std::to_string(get_next_id()));
 
-    if(f_severity < f_logger->get_lowest_severity()
-    || f_severity == severity_t::SEVERITY_OFF)
-    {
-        f_null.reset(new null_buffer);
-        std::ostream & ref = *this;
-        f_saved_buffer = ref.rdbuf(f_null.get());
-    }
+message::message(
+          severity_t sev
+        , call_site const & site)
+    : std::basic_ostream<char>(nullptr)
+    , f_logger(logger::get_instance())
+{
+    rdbuf(&f_buffer);
+    reset(sev, site);
 }
 
 
 message::message(std::basic_stringstream<char> const & m, message const & msg)
-    : f_logger(msg.f_logger)
-    , f_timestamp(msg.f_timestamp)
-    , f_severity(msg.f_severity)
-    , f_filename(msg.f_filename)
-    , f_funcname(msg.f_funcname)
-    , f_line(msg.f_line)
-    , f_column(msg.f_column)
-    , f_recursive_message(msg.f_recursive_message)
-    , f_environment(msg.f_environment)
-    , f_components(msg.f_components)
-    , f_fields(msg.f_fields)
-    , f_null(null_buffer::pointer_t())
-    , f_saved_buffer(nullptr)
-    , f_copy(true)
+    : std::basic_ostream<char>(nullptr)
+    , f_logger(msg.f_logger)
 {
+    rdbuf(&f_buffer);
+    copy_fields(msg);
     *this << m.rdbuf();
 }
 
 
+message::message(message const & m, message const & msg)
+    : std::basic_ostream<char>(nullptr)
+    , f_logger(msg.f_logger)
+{
+    rdbuf(&f_buffer);
+    copy_fields(msg);
+
+    std::string_view const content(m.f_buffer.view());
+    write(content.data(), content.length());
+    m.f_buffer.render_deferred(rdbuf());
+}
+
+
 message::~message()
 {
-    if(f_saved_buffer != nullptr)
+}
+
+
+/** \brief Initialize the message as if it were just created.
+ *
+ * This function is used by the constructor and by the message pool to
+ * prepare a message for a new log. A message which gets reused keeps
+ * its buffers so in most cases no memory needs to be allocated.
+ *
+ * \param[in] sev  The severity of the message.
+ * \param[in] location  The location where the message is being created.
+ */
+void message::reset(severity_t sev, std::source_location const & location)
+{
+    set_location(location);
+    reset(sev);
+}
+
+
+/** \brief Initialize the message from a call site.
+ *
+ * The message keeps a pointer to the call site instead of copying its
+ * filename and function name.
+ *
+ * \param[in] sev  The severity of the message.
+ * \param[in] site  The static descriptor of the SNAP_LOG_...() statement.
+ */
+void message::reset(severity_t sev, call_site const & site)
+{
+    f_call_site = &site;
+    f_static_filename = site.get_filename();
+    f_static_funcname = site.get_function();
+    f_line = site.get_line();
+    f_column = site.get_column();
+    reset(sev);
+}
+
+
+/** \brief Initialize all but the location of a message.
+ *
+ * \param[in] sev  The severity of the message.
+ */
+void message::reset(severity_t sev)
+{
+    clear_stream();
+
+    f_severity = sev;
+    f_recursive_message = false;
+    f_environment = create_environment();
+    f_components.reset();
+    f_default_fields = f_logger->get_default_field_list();
+    f_fields.clear();
+    f_nested_diagnostics.clear();
+    f_context_diagnostics.clear();
+    f_copy = false;
+    f_statement = false;
+
+    switch(detail::g_clock_source.load(std::memory_order_acquire))
+    {
+    case clock_source_t::CLOCK_SOURCE_TSC:
+        // the conversion to a timespec happens in get_timestamp()
+        //
+        f_tsc = detail::read_tsc();
+        break;
+
+    case clock_source_t::CLOCK_SOURCE_REALTIME:
+        f_tsc = 0;
+        clock_gettime(CLOCK_REALTIME, &f_timestamp);
+        break;
+
+    default:
+        f_tsc = 0;
+        clock_gettime(CLOCK_REALTIME_COARSE, &f_timestamp);
+        break;
+
+    }
+
+    // the identifier is only converted to a string if a format uses it
+    //
+    f_id = detail::get_next_message_id();
+
+    if(!is_severity_enabled(f_severity)
+    || f_severity == severity_t::SEVERITY_OFF)
     {
-        std::ostream & ref = *this;
-        ref.rdbuf(f_saved_buffer);
+        if(f_null == nullptr)
+        {
+            f_null.reset(new null_buffer);
+        }
+        rdbuf(f_null.get());
     }
 }
 
 
+/** \brief Make this message a copy of another message.
+ *
+ * This function is used by the message pool to copy a message which
+ * gets sent to the asynchronous thread. The message identifier is
+ * copied as is since it is part of the fields.
+ *
+ * The deferred part of \p rhs, if any, gets rendered in the copy by
+ * the calling thread. The messages of the SNAP_LOG_...() statements are
+ * not copied (see detach_from_thread()) so their formatting still
+ * happens in the asynchronous thread.
+ *
+ * \param[in] rhs  The message to copy.
+ */
+void message::copy(message const & rhs)
+{
+    clear_stream();
+    copy_fields(rhs);
+
+    std::string_view const content(rhs.f_buffer.view());
+    write(content.data(), content.length());
+    rhs.f_buffer.render_deferred(rdbuf());
+}
+
+
+/** \brief Copy all the fields except the message itself.
+ *
+ * \param[in] rhs  The message to copy the fields from.
+ */
+void message::copy_fields(message const & rhs)
+{
+    f_logger = rhs.f_logger;
+    f_timestamp = rhs.f_timestamp;
+    f_tsc = rhs.f_tsc;
+    f_severity = rhs.f_severity;
+    f_id = rhs.f_id;
+    f_call_site = rhs.f_call_site;
+    f_static_filename = rhs.f_static_filename;
+    f_static_funcname = rhs.f_static_funcname;
+    if(f_static_filename == nullptr)
+    {
+        f_filename = rhs.f_filename;
+    }
+    if(f_static_funcname == nullptr)
+    {
+        f_funcname = rhs.f_funcname;
+    }
+    f_line = rhs.f_line;
+    f_column = rhs.f_column;
+    f_recursive_message = rhs.f_recursive_message;
+    f_environment = rhs.f_environment;
+    f_components = rhs.f_components;
+    f_default_fields = rhs.f_default_fields;
+    f_fields = rhs.f_fields;
+
+    // the copy may be processed by another thread so it needs its own
+    // copy of the nested and context diagnostics of the thread which
+    // created it
+    //
+    f_nested_diagnostics = rhs.f_copy
+                                ? rhs.f_nested_diagnostics
+                                : get_thread_nested_diagnostics();
+    f_context_diagnostics = rhs.f_copy
+                                ? rhs.f_context_diagnostics
+                                : get_thread_context_diagnostics();
+    f_copy = true;
+}
+
+
+/** \brief Prepare the message to be processed by another thread.
+ *
+ * The message of a SNAP_LOG_...() statement cannot be accessed by the
+ * thread which created it once sent. Instead of a copy, the logger gives
+ * that very message to the asynchronous thread. This function saves
+ * the nested and context diagnostics of the current thread in the
+ * message first, as copy_fields() does for a copy.
+ */
+void message::detach_from_thread()
+{
+    if(!f_copy)
+    {
+        f_nested_diagnostics = get_thread_nested_diagnostics();
+        f_context_diagnostics = get_thread_context_diagnostics();
+        f_copy = true;
+    }
+    f_statement = false;
+}
+
+
+/** \brief Clear the message stream.
+ *
+ * This function empties the stream buffer without releasing its memory
+ * and restores the buffer if it was replaced by the null buffer.
+ *
+ * The formatting flags are also restored to their defaults so a message
+ * reused from the pool does not inherit a manipulator such as std::hex.
+ */
+void message::clear_stream()
+{
+    if(rdbuf() != &f_buffer)
+    {
+        rdbuf(&f_buffer);
+    }
+    f_buffer.clear();
+
+    flags(std::ios_base::dec | std::ios_base::skipws);
+    width(0);
+    precision(6);
+    fill(' ');
+    clear();
+}
+
+
 severity_t message::default_severity()
 {
     return logger::get_instance()->get_default_severity();
@@ -177,21 +748,40 @@ void message::set_severity(severity_t severity)
 
 void message::set_location(std::source_location const & location)
 {
-    f_filename = location.file_name();
-    f_funcname = location.function_name();
+    f_call_site = nullptr;
+    f_static_filename = location.file_name();
+    f_static_funcname = location.function_name();
     f_line = location.line();
     f_column = location.column();
 }
 
 
+/** \brief Change the filename of the message.
+ *
+ * The message keeps its own copy of \p filename. Since the message does
+ * not match its call site anymore, it gets detached from it.
+ *
+ * \param[in] filename  The new filename.
+ */
 void message::set_filename(std::string const & filename)
 {
+    f_call_site = nullptr;
+    f_static_filename = nullptr;
     f_filename = filename;
 }
 
 
+/** \brief Change the function name of the message.
+ *
+ * The message keeps its own copy of \p funcname. Since the message does
+ * not match its call site anymore, it gets detached from it.
+ *
+ * \param[in] funcname  The new function name.
+ */
 void message::set_function(std::string const & funcname)
 {
+    f_call_site = nullptr;
+    f_static_funcname = nullptr;
     f_funcname = funcname;
 }
 
@@ -215,12 +805,14 @@ void message::set_recursive_message(bool state) const
 
 void message::set_precise_time()
 {
+    f_tsc = 0;
     clock_gettime(CLOCK_REALTIME, &f_timestamp);
 }
 
 
 void message::set_timestamp(timespec const & timestamp)
 {
+    f_tsc = 0;
     f_timestamp = timestamp;
 }
 
@@ -248,12 +840,12 @@ void message::add_component(component::pointer_t c)
                 + "\" cannot be added to this message as it is mutually exclusive with one or more of the other components that were already added to this message.");
         }
 
-        f_components.insert(c);
+        f_components.set(c->get_index());
     }
 }
 
 
-void message::add_field(std::string const & name, std::string const & value)
+void message::add_field(std::string const & name, field_value const & value)
 {
     if(!name.empty())
     {
@@ -266,11 +858,24 @@ void message::add_field(std::string const & name, std::string const & value)
                   " Do not start your field names with an underscore (_).");
         }
 
-        f_fields[name] = value;
+        f_fields.set(name, value);
     }
 }
 
 
+/** \brief Get the message identifier.
+ *
+ * Each message is given a unique identifier when created. It is also
+ * available as the "id" field.
+ *
+ * \return The message identifier.
+ */
+std::uint32_t message::get_id() const
+{
+    return f_id;
+}
+
+
 std::shared_ptr<logger> message::get_logger() const
 {
     return f_logger;
@@ -283,24 +888,64 @@ severity_t message::get_severity() const
 }
 
 
+/** \brief Get the time when the message was created.
+ *
+ * When the TSC clock source is used, the raw TSC value gets converted
+ * to a timespec the first time this function gets called.
+ *
+ * \return The message timestamp.
+ */
 timespec const & message::get_timestamp() const
 {
+    if(f_tsc != 0)
+    {
+        f_timestamp = detail::tsc_to_timespec(f_tsc);
+        f_tsc = 0;
+    }
     return f_timestamp;
 }
 
 
-std::string const & message::get_filename() const
+/** \brief Get the name of the file where the message was logged.
+ *
+ * The name is the static string of the call site or std::source_location
+ * unless it was changed with set_filename().
+ *
+ * \return The filename of the SNAP_LOG_...() statement.
+ */
+std::string_view message::get_filename() const
 {
+    if(f_static_filename != nullptr)
+    {
+        return f_static_filename;
+    }
     return f_filename;
 }
 
 
-std::string const & message::get_function() const
+/** \brief Get the name of the function where the message was logged.
+ *
+ * The name is the static string of the call site or std::source_location
+ * unless it was changed with set_function().
+ *
+ * \return The name of the function of the SNAP_LOG_...() statement.
+ */
+std::string_view message::get_function() const
 {
+    if(f_static_funcname != nullptr)
+    {
+        return f_static_funcname;
+    }
     return f_funcname;
 }
 
 
+call_site const * message::get_call_site() const
+{
+    return f_call_site;
+}
+
+
 std::uint_least32_t message::get_line() const
 {
     return f_line;
@@ -321,22 +966,127 @@ bool message::get_recursive_message() const
 
 bool message::has_component(component::pointer_t c) const
 {
-    return f_components.find(c) != f_components.end();
+    return c != nullptr && f_components.test(c->get_index());
 }
 
 
-component::set_t const & message::get_components() const
+/** \brief Get the set of components attached to this message.
+ *
+ * The components are saved in a mask. This function converts that mask
+ * to a set. It is kept for compatibility, use get_component_mask() or
+ * has_component() instead.
+ *
+ * \return The set of components of this message.
+ */
+component::set_t message::get_components() const
+{
+    return to_component_set(f_components);
+}
+
+
+/** \brief Get the mask of components attached to this message.
+ *
+ * Bit N of the mask is set when the component with index N was added
+ * to this message.
+ *
+ * \return The mask of components of this message.
+ */
+component::mask_t const & message::get_component_mask() const
 {
     return f_components;
 }
 
 
+/** \brief Get the nested diagnostics of this message.
+ *
+ * A message which was copied (i.e. to be sent to the asynchronous thread)
+ * carries the nested diagnostics of the thread which created it. The
+ * other messages are processed by the thread which created them so the
+ * function returns the nested diagnostics of the current thread.
+ *
+ * \return A reference to the nested diagnostics of this message.
+ */
+string_vector_t const & message::get_nested_diagnostics() const
+{
+    if(f_copy)
+    {
+        return f_nested_diagnostics;
+    }
+    return get_thread_nested_diagnostics();
+}
+
+
+/** \brief Get the context diagnostics of this message.
+ *
+ * Like the nested diagnostics, a copied message carries the context
+ * diagnostics of the thread which created it. The other messages use
+ * the context of the current thread.
+ *
+ * \return A reference to the context diagnostics of this message.
+ *
+ * \sa scoped_context
+ */
+context_diagnostics_t const & message::get_context_diagnostics() const
+{
+    if(f_copy)
+    {
+        return f_context_diagnostics;
+    }
+    return get_thread_context_diagnostics();
+}
+
+
 environment::pointer_t message::get_environment() const
 {
     return f_environment;
 }
 
 
+/** \brief Check whether the message can be rendered later.
+ *
+ * When the logger is asynchronous, the formatting of a message can
+ * happen in the logger thread. This function returns true in that
+ * case, unless the message is being ignored.
+ *
+ * \return true if defer() can be used with this message.
+ */
+bool message::can_defer() const
+{
+    return detail::g_published_asynchronous.load(std::memory_order_relaxed)
+        && rdbuf() == &f_buffer;
+}
+
+
+bool message::empty() const
+{
+    return f_buffer.empty();
+}
+
+
+/** \brief Get a copy of the message as written so far.
+ *
+ * \return The message string, including a final newline if any.
+ */
+std::string message::str() const
+{
+    const_cast<message_buffer &>(f_buffer).render();
+    return f_buffer.str();
+}
+
+
+/** \brief Get a view of the message as written so far.
+ *
+ * The view remains valid until the message gets modified.
+ *
+ * \return A view of the message characters.
+ */
+std::string_view message::view() const
+{
+    const_cast<message_buffer &>(f_buffer).render();
+    return f_buffer.view();
+}
+
+
 std::string message::get_message() const
 {
     std::string s(str());
@@ -438,76 +1188,219 @@ std::string message::get_field(std::string const & name) const
     if(!name.empty()
     && name[0] == '_')
     {
-        switch(get_system_field_from_name(name))
+        return get_field(get_system_field_from_name(name));
+    }
+
+    field_value const * value(f_fields.find(name));
+    if(value == nullptr)
+    {
+        if(name == g_system_field_names[static_cast<std::size_t>(system_field_t::SYSTEM_FIELD_ID)])
         {
-        case system_field_t::SYSTEM_FIELD_MESSAGE:
-            return get_message();
+            return std::to_string(f_id);
+        }
+        if(f_default_fields != nullptr)
+        {
+            value = f_default_fields->find(name);
+        }
+    }
+    return value == nullptr ? std::string() : value->to_string();
+}
 
-        case system_field_t::SYSTEM_FIELD_TIMESTAMP:
-            // TODO: offer ways to get the date & time converted to strings
+
+/** \brief Get a field using its interned name.
+ *
+ * This version compares the name pointers instead of the strings. The
+ * \p name pointer must have been returned by intern_field_name(). The
+ * ${field:name=...} variable interns its name when the format is parsed
+ * and then uses this function.
+ *
+ * This function does not check for system fields. Use the
+ * get_field(system_field_t) function for those.
+ *
+ * \param[in] name  The interned name of the field.
+ *
+ * \return The value of the field or an empty string.
+ */
+std::string message::get_field(std::string const * name) const
+{
+    field_value const * value(f_fields.find(name));
+    if(value == nullptr)
+    {
+        if(*name == g_system_field_names[static_cast<std::size_t>(system_field_t::SYSTEM_FIELD_ID)])
+        {
+            return std::to_string(f_id);
+        }
+        if(f_default_fields != nullptr)
+        {
+            value = f_default_fields->find(name);
+        }
+    }
+    return value == nullptr ? std::string() : value->to_string();
+}
+
+
+/** \brief Get the value of a system field.
+ *
+ * \param[in] field  The system field to retrieve.
+ *
+ * \return The value of the field converted to a string or an empty string
+ * if \p field is not a valid system field.
+ */
+std::string message::get_field(system_field_t field) const
+{
+    switch(field)
+    {
+    case system_field_t::SYSTEM_FIELD_MESSAGE:
+        return get_message();
+
+    case system_field_t::SYSTEM_FIELD_TIMESTAMP:
+        // TODO: offer ways to get the date & time converted to strings
+        {
+            timespec const & ts(get_timestamp());
+            std::string timestamp(std::to_string(ts.tv_sec));
+            if(ts.tv_nsec != 0)
             {
-                std::string timestamp(std::to_string(f_timestamp.tv_sec));
-                if(f_timestamp.tv_nsec != 0)
+                std::string nsec(std::to_string(ts.tv_nsec));
+                while(nsec.length() < 9)
                 {
-                    std::string nsec(std::to_string(f_timestamp.tv_nsec));
-                    while(nsec.length() < 9)
-                    {
-                        nsec = '0' + nsec;
-                    }
-                    while(nsec.back() == '0')
-                    {
-                        nsec.pop_back();
-                    }
-                    timestamp += '.';
-                    timestamp += nsec;
+                    nsec = '0' + nsec;
                 }
-                return timestamp;
+                while(nsec.back() == '0')
+                {
+                    nsec.pop_back();
+                }
+                timestamp += '.';
+                timestamp += nsec;
             }
+            return timestamp;
+        }
 
-        case system_field_t::SYSTEM_FIELD_SEVERITY:
-            {
-                severity::pointer_t sev(snaplogger::get_severity(f_severity));
-                return sev == nullptr ? "<unknown>" : sev->get_name();
-            }
+    case system_field_t::SYSTEM_FIELD_SEVERITY:
+        {
+            severity_table_pointer_t const table(get_severity_table());
+            severity_entry const & entry((*table)[static_cast<std::size_t>(f_severity)]);
+            return entry.f_severity == nullptr ? "<unknown>" : entry.f_name;
+        }
 
-        case system_field_t::SYSTEM_FIELD_FILENAME:
-            return f_filename;
+    case system_field_t::SYSTEM_FIELD_ID:
+        return std::to_string(f_id);
 
-        case system_field_t::SYSTEM_FIELD_FUNCTION_NAME:
-            return f_funcname;
+    case system_field_t::SYSTEM_FIELD_FILENAME:
+        return std::string(get_filename());
 
-        case system_field_t::SYSTEM_FIELD_LINE:
-            return std::to_string(f_line);
+    case system_field_t::SYSTEM_FIELD_FUNCTION_NAME:
+        return std::string(get_function());
 
-        case system_field_t::SYSTEM_FIELD_COLUMN:
-            return std::to_string(f_column);
+    case system_field_t::SYSTEM_FIELD_LINE:
+        return std::to_string(f_line);
 
-        default:
-            return std::string();
+    case system_field_t::SYSTEM_FIELD_COLUMN:
+        return std::to_string(f_column);
+
+    default:
+        return std::string();
 
-        }
     }
+}
 
-    auto it(f_fields.find(name));
-    if(it == f_fields.end())
+
+/** \brief Get all the fields converted to strings.
+ *
+ * This function converts all the field values to strings and returns
+ * them in a map sorted by name. The map includes the logger default
+ * fields unless the message overrides them. To avoid the conversions,
+ * use the get_field_list() and get_default_field_list() functions instead.
+ *
+ * \return A map of the fields of this message.
+ */
+field_map_t message::get_fields() const
+{
+    field_map_t result;
+    if(f_default_fields != nullptr)
     {
-        return std::string();
+        result = f_default_fields->to_map();
     }
-    return it->second;
+    result[g_system_field_names[static_cast<std::size_t>(system_field_t::SYSTEM_FIELD_ID)]] = std::to_string(f_id);
+    for(std::size_t idx(0); idx < f_fields.size(); ++idx)
+    {
+        result[f_fields.get_name(idx)] = f_fields.get_value(idx).to_string();
+    }
+    return result;
 }
 
 
-field_map_t const & message::get_fields() const
+/** \brief Get the fields added to this message.
+ *
+ * This list does not include the logger default fields, see
+ * get_default_field_list() for those.
+ *
+ * \return The list of fields specific to this message.
+ */
+field_list const & message::get_field_list() const
 {
     return f_fields;
 }
 
 
+/** \brief Get the default fields of this message.
+ *
+ * The default fields are a snapshot of the logger default fields taken
+ * when the message was created. The snapshot is shared by all the
+ * messages created until the default fields change.
+ *
+ * \return The default fields, which may be a null pointer.
+ */
+field_list::pointer_t message::get_default_field_list() const
+{
+    return f_default_fields;
+}
+
+
 message::pointer_t create_message(
       severity_t sev
     , std::source_location const & location)
 {
-    return std::make_shared<message>(sev, location);
+    return g_message_pool.get(sev, location);
+}
+
+
+/** \brief Create a message from a static call site.
+ *
+ * This is the function used by the SNAP_LOG_...() macros. The message
+ * only keeps a pointer to the call site so the filename and function
+ * name do not get copied.
+ *
+ * The message must not be used anymore once passed to send_message().
+ * In asynchronous mode, it gets processed by the logger thread as is,
+ * without being copied.
+ *
+ * \param[in] sev  The severity of the new message.
+ * \param[in] site  The call site of the SNAP_LOG_...() statement.
+ *
+ * \return A pointer to the new message.
+ */
+message::pointer_t create_message(
+      severity_t sev
+    , call_site const & site)
+{
+    return g_message_pool.get_statement(sev, site);
+}
+
+
+/** \brief Create a copy of a message.
+ *
+ * This function creates a copy of the specified message. The copy
+ * comes from the message pool of the current thread. It gets recycled
+ * once released, even if it gets released by another thread (i.e. the
+ * asynchronous thread is done with it).
+ *
+ * \param[in] msg  The message to copy.
+ *
+ * \return A pointer to the new copy.
+ */
+message::pointer_t copy_message(message const & msg)
+{
+    return g_message_pool.copy(msg);
 }
 
 
@@ -519,6 +1412,19 @@ void send_message(std::basic_ostream<char> & out)
         throw not_a_message("the 'out' parameter to the send_message() function is expected to be a snaplogger::message object.");
     }
 
+    if(msg->f_statement)
+    {
+        // the message of a SNAP_LOG_...() statement can be handed over
+        // to the asynchronous thread instead of being copied
+        //
+        message::pointer_t const m(msg->weak_from_this().lock());
+        if(m != nullptr)
+        {
+            logger::get_instance()->log_message(m);
+            return;
+        }
+    }
+
     logger::get_instance()->log_message(*msg);
 }
 
@@ -567,7 +1473,7 @@ void send_stack_trace(std::exception const & e)
  */
 std::uint32_t get_last_message_id()
 {
-    return g_message_id;
+    return g_message_id.load(std::memory_order_relaxed);
 }
 
 
@@ -21,16 +21,19 @@
  * \brief Handle the message generator.
  *
  * This file declares the base message class which is derived from an
- * std::stringstram. This allows you to use our logger with `<<`
+ * std::ostream. This allows you to use our logger with `<<`
  * to send anything that the `<<` operator understands to the logs.
  */
 
 
 // self
 //
+#include    <snaplogger/call_site.h>
 #include    <snaplogger/component.h>
 #include    <snaplogger/environment.h>
+#include    <snaplogger/field_list.h>
 #include    <snaplogger/severity.h>
+#include    <snaplogger/version.h>
 
 
 
@@ -46,9 +49,24 @@
 
 // C++
 //
+#include    <atomic>
+#include    <cstddef>
+#include    <iterator>
+#include    <memory>
+#include    <new>
+#include    <ostream>
 #include    <source_location>
 #include    <sstream>
 #include    <streambuf>
+#include    <string_view>
+#include    <tuple>
+#include    <type_traits>
+
+#ifdef SNAPLOGGER_USE_FMT
+#include    <fmt/format.h>
+#else
+#include    <format>
+#endif
 
 
 // C
@@ -75,6 +93,88 @@ public:
 };
 
 
+// a deferred message is the raw data of a message which gets rendered
+// only once the text is needed; in asynchronous mode that happens in the
+// logger thread instead of the thread emitting the message
+//
+class deferred_message
+{
+public:
+    virtual             ~deferred_message() {}
+
+    virtual void        render(std::streambuf * out) const = 0;
+};
+
+
+// the message_buffer keeps short messages in an inline buffer so creating
+// a message does not allocate a stream buffer; longer messages spill to
+// an std::string which is kept (with its capacity) until the message
+// gets destroyed
+//
+// the deferred part of a message is also created in place when it fits
+// in DEFERRED_SIZE bytes so deferring the formatting does not allocate
+//
+class message_buffer
+    : public std::streambuf
+{
+public:
+    static constexpr std::size_t    INLINE_SIZE = 256;
+    static constexpr std::size_t    DEFERRED_SIZE = 192;
+
+                        message_buffer();
+                        message_buffer(message_buffer const & rhs) = delete;
+    virtual             ~message_buffer() override;
+
+    message_buffer &    operator = (message_buffer const & rhs) = delete;
+
+    bool                empty() const;
+    std::size_t         size() const;
+    std::string_view    view() const;
+    std::string         str() const;
+    void                clear();
+    void                render();
+    void                render_deferred(std::streambuf * out) const;
+
+    template<typename T, typename ... Args>
+    void                set_deferred(Args && ... args)
+                        {
+                            render();
+
+                            if constexpr (sizeof(T) <= DEFERRED_SIZE
+                                       && alignof(T) <= alignof(std::max_align_t))
+                            {
+                                f_deferred = new (f_deferred_storage) T(std::forward<Args>(args)...);
+                            }
+                            else
+                            {
+                                f_deferred = new T(std::forward<Args>(args)...);
+                            }
+                            catch_next_write();
+                        }
+
+protected:
+    virtual int         overflow(int c) override;
+    virtual std::streamsize
+                        xsputn(char const * s, std::streamsize n) override;
+    virtual pos_type    seekoff(
+                              off_type off
+                            , std::ios_base::seekdir dir
+                            , std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) override;
+
+private:
+    char *              storage_end();
+    void                grow(std::size_t extra);
+    void                catch_next_write();
+    void                destroy_deferred(deferred_message * deferred);
+
+    char                f_inline[INLINE_SIZE] = {};
+    std::string         f_spill = std::string();
+    deferred_message *  f_deferred = nullptr;
+    alignas(std::max_align_t) unsigned char
+                        f_deferred_storage[DEFERRED_SIZE] = {};
+};
+
+
 enum class system_field_t
 {
     SYSTEM_FIELD_UNDEFINED = -1,     // used for still undefined system fields
@@ -92,17 +192,23 @@ enum class system_field_t
 };
 
 
-typedef std::map<std::string, std::string>      field_map_t;
+namespace detail
+{
+class message_pool;
+}
+// detail namespace
 
 
-// the message class is final because the destructor does tricks which
-// would not work right if derived further
+// the message class is final because its std::ostream base uses the
+// f_buffer member as its stream buffer which would not work right if
+// derived further
 //
-// also we do not offer a shared pointer because we expect the message
-// object to be created and immediately destroyed from the stack
+// the create_message() function returns messages from a per thread pool
+// so they can be reused once released instead of reallocated each time
 //
 class message final
-    : public std::basic_stringstream<char>
+    : public std::basic_ostream<char>
+    , public std::enable_shared_from_this<message>
 {
 public:
     typedef std::shared_ptr<message>            pointer_t;
@@ -111,7 +217,9 @@ public:
                                 message(
                                           severity_t sev = default_severity()
                                         , std::source_location const & location = std::source_location::current());
+                                message(severity_t sev, call_site const & site);
                                 message(std::basic_stringstream<char> const & m, message const & msg);
+                                message(message const & m, message const & msg);
                                 message(message const & rhs) = delete;
     virtual                     ~message();
 
@@ -130,40 +238,81 @@ public:
     void                        set_timestamp(timespec const & timestamp);
     bool                        can_add_component(component::pointer_t c) const;
     void                        add_component(component::pointer_t c);
-    void                        add_field(std::string const & name, std::string const & value);
+    void                        add_field(std::string const & name, field_value const & value);
+    bool                        can_defer() const;
+
+    template<typename T, typename ... Args>
+    void                        defer(Args && ... args)
+                                {
+                                    f_buffer.set_deferred<T>(std::forward<Args>(args)...);
+                                }
 
     std::shared_ptr<logger>     get_logger() const;
     severity_t                  get_severity() const;
+    std::uint32_t               get_id() const;
     timespec const &            get_timestamp() const;
-    std::string const &         get_filename() const;
-    std::string const &         get_function() const;
+    std::string_view            get_filename() const;
+    std::string_view            get_function() const;
+    call_site const *           get_call_site() const;
     std::uint_least32_t         get_line() const;
     std::uint_least32_t         get_column() const;
     bool                        get_recursive_message() const;
     bool                        has_component(component::pointer_t c) const;
-    component::set_t const &    get_components() const;
+    component::set_t            get_components() const;
+    component::mask_t const &   get_component_mask() const;
     environment::pointer_t      get_environment() const;
+    string_vector_t const &     get_nested_diagnostics() const;
+    context_diagnostics_t const &
+                                get_context_diagnostics() const;
+    bool                        empty() const;
+    std::string                 str() const;
+    std::string_view            view() const;
     std::string                 get_message() const;
     static char const *         get_system_field_name(system_field_t field);
     static system_field_t       get_system_field_from_name(std::string const & name);
     std::string                 get_field(std::string const & name) const;
-    field_map_t const &         get_fields() const;
+    std::string                 get_field(std::string const * name) const;
+    std::string                 get_field(system_field_t field) const;
+    field_map_t                 get_fields() const;
+    field_list const &          get_field_list() const;
+    field_list::pointer_t       get_default_field_list() const;
 
 private:
+    friend class detail::message_pool;
+    friend class logger;
+    friend void                 send_message(std::basic_ostream<char> & msg);
+
+    void                        reset(severity_t sev, std::source_location const & location);
+    void                        reset(severity_t sev, call_site const & site);
+    void                        reset(severity_t sev);
+    void                        copy(message const & rhs);
+    void                        copy_fields(message const & rhs);
+    void                        detach_from_thread();
+    void                        clear_stream();
+
     std::shared_ptr<logger>     f_logger = std::shared_ptr<logger>(); // make sure it does not go away under our feet
-    timespec                    f_timestamp = timespec();
+    mutable timespec            f_timestamp = timespec();
+    mutable std::uint64_t       f_tsc = 0;
     severity_t                  f_severity = severity_t::SEVERITY_INFORMATION;
+    std::uint32_t               f_id = 0;
+    call_site const *           f_call_site = nullptr;
+    char const *                f_static_filename = nullptr;
+    char const *                f_static_funcname = nullptr;
     std::string                 f_filename = std::string();
     std::string                 f_funcname = std::string();
     std::uint_least32_t         f_line = 0;
     std::uint_least32_t         f_column = 0;
     mutable bool                f_recursive_message = false;
     environment::pointer_t      f_environment = environment::pointer_t();
-    component::set_t            f_components = component::set_t();
-    field_map_t                 f_fields = field_map_t();
+    component::mask_t           f_components = component::mask_t();
+    field_list::pointer_t       f_default_fields = field_list::pointer_t();
+    field_list                  f_fields = field_list();
+    string_vector_t             f_nested_diagnostics = string_vector_t();
+    context_diagnostics_t       f_context_diagnostics = context_diagnostics_t();
+    message_buffer              f_buffer = message_buffer();
     null_buffer::pointer_t      f_null = null_buffer::pointer_t();
-    std::streambuf *            f_saved_buffer = nullptr;
     bool                        f_copy = false;
+    bool                        f_statement = false;
 };
 
 
@@ -220,10 +369,10 @@ precise_time(std::basic_ostream<CharT, Traits> & os)
 struct field_t
 {
     std::string             f_name;
-    std::string             f_value;
+    field_value             f_value;
 };
 
-inline field_t field(std::string const & name, std::string const & value)
+inline field_t field(std::string const & name, field_value const & value)
 {
     return { name, value };
 }
@@ -244,9 +393,144 @@ operator << (std::basic_ostream<CharT, Traits> & os, field_t const & f)
 
 
 
+namespace detail
+{
+// the formatting functions come from std:: or, if the compiler does not
+// offer <format>, from the {fmt} library (see SNAPLOGGER_USE_FMT); in
+// the latter case, custom types need a fmt::formatter<> specialization
+//
+#ifdef SNAPLOGGER_USE_FMT
+namespace format_impl = ::fmt;
+#else
+namespace format_impl = ::std;
+#endif
+}
+// detail namespace
+
+
+/** \brief Hold the format string and arguments of a formatted message.
+ *
+ * The formatted() function returns this object which, once sent to a
+ * message with `<<`, writes its output with std::vformat_to() directly
+ * (or fmt::vformat_to()) in the message buffer. This avoids the iostream operators for each
+ * number, which are fairly slow.
+ *
+ * The object only keeps references to its arguments so it has to be
+ * used in the same statement, which is what the SNAP_LOG_..._FMT()
+ * macros do.
+ */
+template<typename ... Args>
+struct formatted_t
+{
+    std::string_view                f_format;
+    std::tuple<Args && ...>         f_args;
+};
+
+
+/** \brief Prepare a formatted message.
+ *
+ * The format string is verified at compile time against the types of
+ * the arguments, as with std::format().
+ *
+ * \param[in] fmt  The std::format() (or fmt::format()) format string.
+ * \param[in] args  The arguments to format.
+ *
+ * \return An object you can send to a message with `<<`.
+ */
+template<typename ... Args>
+inline formatted_t<Args...> formatted(detail::format_impl::format_string<Args...> fmt, Args && ... args)
+{
+#ifdef SNAPLOGGER_USE_FMT
+    ::fmt::string_view const f(fmt);
+    return { std::string_view(f.data(), f.size()), std::forward_as_tuple(std::forward<Args>(args)...) };
+#else
+    return { fmt.get(), std::forward_as_tuple(std::forward<Args>(args)...) };
+#endif
+}
+
+
+// strings are copied since the caller's buffers may be gone by the time
+// the message gets rendered; other arguments are copied as is
+//
+template<typename T>
+using deferred_argument_t = std::conditional_t<
+          std::is_same_v<std::decay_t<T>, char const *>
+            || std::is_same_v<std::decay_t<T>, char *>
+            || std::is_same_v<std::decay_t<T>, std::string_view>
+        , std::string
+        , std::decay_t<T>>;
+
+
+/** \brief The deferred version of a formatted message.
+ *
+ * When the logger is asynchronous, the SNAP_LOG_..._FMT() macros save
+ * a copy of their arguments in this object and the formatting happens
+ * in the logger thread. The format string is not copied since
+ * the format_string requires a constant.
+ */
+template<typename ... Args>
+class deferred_format
+    : public deferred_message
+{
+public:
+    deferred_format(formatted_t<Args...> const & f)
+        : f_format(f.f_format)
+        , f_args(f.f_args)
+    {
+    }
+
+    virtual void render(std::streambuf * out) const override
+    {
+        std::apply(
+              [this, out](auto const & ... args)
+              {
+                  detail::format_impl::vformat_to(
+                          std::ostreambuf_iterator<char>(out)
+                        , f_format
+                        , detail::format_impl::make_format_args(args...));
+              }
+            , f_args);
+    }
+
+private:
+    std::string_view                            f_format;
+    std::tuple<deferred_argument_t<Args>...>    f_args;
+};
+
+
+template<typename ... Args>
+inline std::ostream &
+operator << (std::ostream & os, formatted_t<Args...> const & f)
+{
+    message * m(dynamic_cast<message *>(&os));
+    if(m != nullptr
+    && m->can_defer())
+    {
+        m->defer<deferred_format<Args...>>(f);
+        return os;
+    }
+
+    std::apply(
+          [&os, &f](auto & ... args)
+          {
+              detail::format_impl::vformat_to(
+                      std::ostreambuf_iterator<char>(os)
+                    , f.f_format
+                    , detail::format_impl::make_format_args(args...));
+          }
+        , f.f_args);
+    return os;
+}
+
+
+
+
+
 message::pointer_t create_message(
               severity_t sev = ::snaplogger::message::default_severity()
             , std::source_location const & location = std::source_location::current());
+message::pointer_t create_message(severity_t sev, call_site const & site);
+message::pointer_t copy_message(message const & msg);
 
 void send_message(std::basic_ostream<char> & msg);
 
@@ -255,39 +539,136 @@ void send_stack_trace(std::exception const & e);
 std::uint32_t get_last_message_id();
 
 
-#define SNAP_LOG_FATAL                  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_FATAL))
-#define SNAP_LOG_EMERG                  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_EMERGENCY))
-#define SNAP_LOG_EMERGENCY              ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_EMERGENCY))
-#define SNAP_LOG_ALERT                  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_ALERT))
-#define SNAP_LOG_CRIT                   ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_CRITICAL))
-#define SNAP_LOG_CRITICAL               ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_CRITICAL))
-#define SNAP_LOG_EXCEPTION              ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_EXCEPTION))
-#define SNAP_LOG_SEVERE                 ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_SEVERE))
-#define SNAP_LOG_NOISY_ERROR            ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_NOISY_ERROR))
-#define SNAP_LOG_ERR                    ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_ERROR))
-#define SNAP_LOG_ERROR                  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_ERROR))
-#define SNAP_LOG_RECOVERABLE_ERROR      ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_RECOVERABLE_ERROR))
-#define SNAP_LOG_MAJOR                  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_MAJOR))
-#define SNAP_LOG_WARN                   ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_WARNING))
-#define SNAP_LOG_WARNING                ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_WARNING))
-#define SNAP_LOG_DEPRECATED             ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_DEPRECATED))
-#define SNAP_LOG_TODO                   ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_TODO))
-#define SNAP_LOG_MINOR                  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_MINOR))
-#define SNAP_LOG_IMPORTANT              ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_IMPORTANT))
-#define SNAP_LOG_INFO                   ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_INFORMATION))
-#define SNAP_LOG_INFORMATION            ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_INFORMATION))
-#define SNAP_LOG_CONFIG_WARN            ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_CONFIGURATION_WARNING))
-#define SNAP_LOG_CONFIGURATION_WARNING  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_CONFIGURATION_WARNING))
-#define SNAP_LOG_CONFIGURATION          ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_CONFIGURATION))
-#define SNAP_LOG_CONFIG                 ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_CONFIGURATION))
-#define SNAP_LOG_VERBOSE                ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_VERBOSE))
-#define SNAP_LOG_UNIMPORTANT            ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_UNIMPORTANT))
-#define SNAP_LOG_NOTICE                 ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_NOTICE))
-#define SNAP_LOG_DEBUG                  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_DEBUG))
-#define SNAP_LOG_NOISY                  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_NOISY))
-#define SNAP_LOG_TRACE                  ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::severity_t::SEVERITY_TRACE))
-
-#define SNAP_LOG_DEFAULT                ::snaplogger::send_message(((*::snaplogger::create_message(::snaplogger::message::default_severity()))
+namespace detail
+{
+extern std::atomic<severity_t>  g_published_lowest_severity;
+extern std::atomic<bool>        g_published_asynchronous;
+
+std::uint32_t                   get_next_message_id();
+}
+// detail namespace
+
+
+/** \brief Check whether a message of that severity would be processed.
+ *
+ * The logger publishes the lowest severity any of its appenders accepts
+ * (or the fatal severity if lower) each time one of those levels changes.
+ * This function reads that value without taking the logger guard so the
+ * SNAP_LOG_...() macros can skip creating a message object, and
+ * evaluating its `<<` arguments, when the message would be dropped anyway.
+ *
+ * \param[in] sev  The severity of the message to be sent.
+ *
+ * \return true if a message of that severity may be sent to an appender.
+ */
+inline bool is_severity_enabled(severity_t sev)
+{
+    return sev >= detail::g_published_lowest_severity.load(std::memory_order_relaxed);
+}
+
+
+// the SNAPLOGGER_COMPILE_MIN_SEVERITY can be defined on your command line
+// (i.e. -DSNAPLOGGER_COMPILE_MIN_SEVERITY=50 or
+// -DSNAPLOGGER_COMPILE_MIN_SEVERITY=::snaplogger::severity_t::SEVERITY_INFORMATION)
+// to completely remove the SNAP_LOG_...() statements with a lower severity
+// from your binary; the condition is a constant so the compiler drops the
+// message creation, the location, and the stream arguments altogether;
+// the logger::set_severity() function still works as expected for all
+// the severities at or above that floor
+//
+#ifndef SNAPLOGGER_COMPILE_MIN_SEVERITY
+#define SNAPLOGGER_COMPILE_MIN_SEVERITY ::snaplogger::severity_t::SEVERITY_ALL
+#endif
+
+
+// the severity check happens before the message gets created so a
+// disabled log statement costs one relaxed load and a branch; the stream
+// arguments are part of the third operand and do not get evaluated; the
+// location is saved in a static call site created the first time the
+// statement runs (see SNAP_LOG_CALL_SITE())
+//
+#define SNAP_LOG_MESSAGE(sev)           (static_cast<int>(sev) < static_cast<int>(SNAPLOGGER_COMPILE_MIN_SEVERITY) || !::snaplogger::is_severity_enabled((sev))) ? static_cast<void>(0) : ::snaplogger::send_message(((*::snaplogger::create_message((sev), SNAP_LOG_CALL_SITE((sev))))
+
+#define SNAP_LOG_FATAL                  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_FATAL)
+#define SNAP_LOG_EMERG                  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_EMERGENCY)
+#define SNAP_LOG_EMERGENCY              SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_EMERGENCY)
+#define SNAP_LOG_ALERT                  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_ALERT)
+#define SNAP_LOG_CRIT                   SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_CRITICAL)
+#define SNAP_LOG_CRITICAL               SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_CRITICAL)
+#define SNAP_LOG_EXCEPTION              SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_EXCEPTION)
+#define SNAP_LOG_SEVERE                 SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_SEVERE)
+#define SNAP_LOG_NOISY_ERROR            SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_NOISY_ERROR)
+#define SNAP_LOG_ERR                    SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_ERROR)
+#define SNAP_LOG_ERROR                  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_ERROR)
+#define SNAP_LOG_RECOVERABLE_ERROR      SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_RECOVERABLE_ERROR)
+#define SNAP_LOG_MAJOR                  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_MAJOR)
+#define SNAP_LOG_WARN                   SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_WARNING)
+#define SNAP_LOG_WARNING                SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_WARNING)
+#define SNAP_LOG_DEPRECATED             SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_DEPRECATED)
+#define SNAP_LOG_TODO                   SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_TODO)
+#define SNAP_LOG_MINOR                  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_MINOR)
+#define SNAP_LOG_IMPORTANT              SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_IMPORTANT)
+#define SNAP_LOG_INFO                   SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_INFORMATION)
+#define SNAP_LOG_INFORMATION            SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_INFORMATION)
+#define SNAP_LOG_CONFIG_WARN            SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_CONFIGURATION_WARNING)
+#define SNAP_LOG_CONFIGURATION_WARNING  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_CONFIGURATION_WARNING)
+#define SNAP_LOG_CONFIGURATION          SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_CONFIGURATION)
+#define SNAP_LOG_CONFIG                 SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_CONFIGURATION)
+#define SNAP_LOG_VERBOSE                SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_VERBOSE)
+#define SNAP_LOG_UNIMPORTANT            SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_UNIMPORTANT)
+#define SNAP_LOG_NOTICE                 SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_NOTICE)
+#define SNAP_LOG_DEBUG                  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_DEBUG)
+#define SNAP_LOG_NOISY                  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_NOISY)
+#define SNAP_LOG_TRACE                  SNAP_LOG_MESSAGE(::snaplogger::severity_t::SEVERITY_TRACE)
+
+#define SNAP_LOG_DEFAULT                SNAP_LOG_MESSAGE(::snaplogger::message::default_severity())
+
+// the _FMT versions use std::format() instead of the `<<` operators for
+// the message itself; the statement still needs to be closed with one
+// of the SNAP_LOG_SEND macros so fields and components can be added:
+//
+//     SNAP_LOG_INFO_FMT("user {} logged in from {}", user, ip)
+//             << SNAP_LOG_FIELD("user", user)
+//             << SNAP_LOG_SEND_SECURELY;
+//
+// when the compiler does not support <format>, the {fmt} library is used
+// instead; the format strings are the same in both cases
+//
+#define SNAP_LOG_MESSAGE_FMT(sev, ...)      SNAP_LOG_MESSAGE(sev) << ::snaplogger::formatted(__VA_ARGS__)
+
+#define SNAP_LOG_FATAL_FMT(...)                 SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_FATAL, __VA_ARGS__)
+#define SNAP_LOG_EMERG_FMT(...)                 SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_EMERGENCY, __VA_ARGS__)
+#define SNAP_LOG_EMERGENCY_FMT(...)             SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_EMERGENCY, __VA_ARGS__)
+#define SNAP_LOG_ALERT_FMT(...)                 SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_ALERT, __VA_ARGS__)
+#define SNAP_LOG_CRIT_FMT(...)                  SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_CRITICAL, __VA_ARGS__)
+#define SNAP_LOG_CRITICAL_FMT(...)              SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_CRITICAL, __VA_ARGS__)
+#define SNAP_LOG_EXCEPTION_FMT(...)             SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_EXCEPTION, __VA_ARGS__)
+#define SNAP_LOG_SEVERE_FMT(...)                SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_SEVERE, __VA_ARGS__)
+#define SNAP_LOG_NOISY_ERROR_FMT(...)           SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_NOISY_ERROR, __VA_ARGS__)
+#define SNAP_LOG_ERR_FMT(...)                   SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_ERROR, __VA_ARGS__)
+#define SNAP_LOG_ERROR_FMT(...)                 SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_ERROR, __VA_ARGS__)
+#define SNAP_LOG_RECOVERABLE_ERROR_FMT(...)     SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_RECOVERABLE_ERROR, __VA_ARGS__)
+#define SNAP_LOG_MAJOR_FMT(...)                 SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_MAJOR, __VA_ARGS__)
+#define SNAP_LOG_WARN_FMT(...)                  SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_WARNING, __VA_ARGS__)
+#define SNAP_LOG_WARNING_FMT(...)               SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_WARNING, __VA_ARGS__)
+#define SNAP_LOG_DEPRECATED_FMT(...)            SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_DEPRECATED, __VA_ARGS__)
+#define SNAP_LOG_TODO_FMT(...)                  SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_TODO, __VA_ARGS__)
+#define SNAP_LOG_MINOR_FMT(...)                 SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_MINOR, __VA_ARGS__)
+#define SNAP_LOG_IMPORTANT_FMT(...)             SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_IMPORTANT, __VA_ARGS__)
+#define SNAP_LOG_INFO_FMT(...)                  SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_INFORMATION, __VA_ARGS__)
+#define SNAP_LOG_INFORMATION_FMT(...)           SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_INFORMATION, __VA_ARGS__)
+#define SNAP_LOG_CONFIG_WARN_FMT(...)           SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_CONFIGURATION_WARNING, __VA_ARGS__)
+#define SNAP_LOG_CONFIGURATION_WARNING_FMT(...) SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_CONFIGURATION_WARNING, __VA_ARGS__)
+#define SNAP_LOG_CONFIGURATION_FMT(...)         SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_CONFIGURATION, __VA_ARGS__)
+#define SNAP_LOG_CONFIG_FMT(...)                SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_CONFIGURATION, __VA_ARGS__)
+#define SNAP_LOG_VERBOSE_FMT(...)               SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_VERBOSE, __VA_ARGS__)
+#define SNAP_LOG_UNIMPORTANT_FMT(...)           SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_UNIMPORTANT, __VA_ARGS__)
+#define SNAP_LOG_NOTICE_FMT(...)                SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_NOTICE, __VA_ARGS__)
+#define SNAP_LOG_DEBUG_FMT(...)                 SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_DEBUG, __VA_ARGS__)
+#define SNAP_LOG_NOISY_FMT(...)                 SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_NOISY, __VA_ARGS__)
+#define SNAP_LOG_TRACE_FMT(...)                 SNAP_LOG_MESSAGE_FMT(::snaplogger::severity_t::SEVERITY_TRACE, __VA_ARGS__)
+
+#define SNAP_LOG_DEFAULT_FMT(...)               SNAP_LOG_MESSAGE_FMT(::snaplogger::message::default_severity(), __VA_ARGS__)
 
 #define SNAP_LOG_FIELD(name, value)     ::snaplogger::field((name), (value))
 
@@ -27,9 +27,7 @@
 //
 #include    "snaplogger/nested_diagnostic.h"
 
-#include    "snaplogger/guard.h"
 #include    "snaplogger/message.h"
-#include    "snaplogger/private_logger.h"
 
 
 // last include
@@ -42,11 +40,31 @@ namespace snaplogger
 {
 
 
+namespace
+{
+
+
+
+/** \brief The nested diagnostics of the current thread.
+ *
+ * Each thread has its own stack so the diagnostics of different threads
+ * do not get mixed and pushing or popping a diagnostic does not require
+ * a lock. The vector keeps its buffer once it grew so short diagnostics
+ * (which fit in the std::string small buffer) do not allocate memory.
+ */
+thread_local string_vector_t    g_nested_diagnostics = string_vector_t();
+
+
+
+}
+// no name namespace
+
+
 
 nested_diagnostic::nested_diagnostic(std::string const & diagnostic, bool emit_enter_exit_events)
     : f_emit_enter_exit_events(emit_enter_exit_events)
 {
-    get_private_logger()->push_nested_diagnostic(diagnostic);
+    g_nested_diagnostics.push_back(diagnostic);
 
     if(f_emit_enter_exit_events)
     {
@@ -70,19 +88,48 @@ nested_diagnostic::~nested_diagnostic()
             << SNAP_LOG_SEND;
     }
 
-    get_private_logger()->pop_nested_diagnostic();
+    g_nested_diagnostics.pop_back();
 }
 
 
+/** \brief Get a copy of the nested diagnostics of the current thread.
+ *
+ * \return The nested diagnostics of the calling thread.
+ */
 string_vector_t get_nested_diagnostics()
 {
-    return get_private_logger()->get_nested_diagnostics();
+    return g_nested_diagnostics;
 }
 
 
+/** \brief Get a copy of the nested diagnostics of a message.
+ *
+ * When a message is copied to be processed by another thread (i.e.
+ * in asynchronous mode), the nested diagnostics of the thread which
+ * created the message are saved in the copy. This function returns
+ * those. Otherwise it returns the nested diagnostics of the current
+ * thread.
+ *
+ * \param[in] msg  The message of which the nested diagnostics are returned.
+ *
+ * \return The nested diagnostics attached to \p msg.
+ */
 string_vector_t get_nested_diagnostics(message const & msg)
 {
-    return get_private_logger(msg)->get_nested_diagnostics();
+    return msg.get_nested_diagnostics();
+}
+
+
+/** \brief Get a reference to the nested diagnostics of the current thread.
+ *
+ * This function does not copy the diagnostics. The reference is only
+ * valid within the calling thread.
+ *
+ * \return A reference to the nested diagnostics of the calling thread.
+ */
+string_vector_t const & get_thread_nested_diagnostics()
+{
+    return g_nested_diagnostics;
 }
 
 
@@ -48,6 +48,7 @@ private:
 
 string_vector_t             get_nested_diagnostics();
 string_vector_t             get_nested_diagnostics(message const & msg);
+string_vector_t const &     get_thread_nested_diagnostics();
 
 
 
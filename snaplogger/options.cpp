@@ -30,6 +30,7 @@
 //
 #include    "snaplogger/options.h"
 
+#include    "snaplogger/clock.h"
 #include    "snaplogger/private_logger.h"
 #include    "snaplogger/map_diagnostic.h"
 #include    "snaplogger/version.h"
@@ -88,6 +89,7 @@ namespace
  * * log-severity
  * * force-severity
  * * log-component
+ * * logger-clock
  * * logger-version
  * * logger-configuration-filenames
  * * logger-plugin-paths
@@ -198,6 +200,17 @@ advgetopt::option const g_options[] =
         , advgetopt::Help("filter logs by component, use ! in front of a name to prevent those logs.")
     ),
 
+    // TIMESTAMPS
+    //
+    advgetopt::define_option(
+          advgetopt::Name("logger-clock")
+        , advgetopt::Flags(advgetopt::all_flags<
+                      advgetopt::GETOPT_FLAG_GROUP_OPTIONS
+                    , advgetopt::GETOPT_FLAG_REQUIRED
+                    , advgetopt::GETOPT_FLAG_SHOW_SYSTEM>())
+        , advgetopt::Help("clock used to timestamp messages: coarse (default), realtime, or tsc (falls back to realtime if the CPU has no invariant TSC).")
+    ),
+
     // AUTO-LOGGING
     //
     advgetopt::define_option(
@@ -762,6 +775,29 @@ bool process_logger_options(advgetopt::getopt & opts
         }
     }
 
+    // TIMESTAMPS
+    //
+    if(opts.is_defined("logger-clock"))
+    {
+        std::string const clock_name(opts.get_string("logger-clock"));
+        clock_source_t source(clock_source_t::CLOCK_SOURCE_COARSE);
+        if(!clock_source_from_name(clock_name, source))
+        {
+            cppthread::log << cppthread::log_level_t::error
+                           << "unknown clock \""
+                           << clock_name
+                           << "\"; try one of: \"coarse\", \"realtime\", or \"tsc\"."
+                           << cppthread::end;
+            result = false;
+        }
+        else if(set_clock_source(source) != source)
+        {
+            cppthread::log << cppthread::log_level_t::warning
+                           << "this CPU does not have an invariant TSC; using the \"realtime\" clock instead."
+                           << cppthread::end;
+        }
+    }
+
     // LIBEXCEPT EXTENSION
     //
     {
@@ -40,6 +40,7 @@
 #include    "snaplogger/console_appender.h"
 #include    "snaplogger/exception.h"
 #include    "snaplogger/file_appender.h"
+#include    "snaplogger/format.h"
 #include    "snaplogger/guard.h"
 #include    "snaplogger/logger.h"
 #include    "snaplogger/syslog_appender.h"
@@ -62,6 +63,16 @@
 #include    <cppthread/runner.h>
 
 
+// C++
+//
+#include    <atomic>
+
+
+// C
+//
+#include    <pthread.h>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
@@ -380,6 +391,74 @@ clog_capture * g_clog_capture = nullptr;
 
 
 
+/** \brief Maximum number of environments kept in the private logger map.
+ *
+ * The environments get removed from the map when their thread exits.
+ * This limit is a safety net in case some threads exit without running
+ * their thread local destructors. Once reached, the environments which
+ * are not referenced anywhere else get removed.
+ *
+ * This is a soft limit. An environment still referenced (by its thread
+ * or by a message) is never removed so a process with more than this
+ * many live threads has a map larger than this limit. The first time
+ * the pruning cannot bring the map under the limit, a warning gets
+ * logged.
+ */
+constexpr std::size_t const g_maximum_environments = 1'000;
+
+
+/** \brief Count the number of fork() calls.
+ *
+ * A child process inherits the thread local environment of the thread
+ * that called fork(). That environment has the wrong PID and TID so the
+ * create_environment() function compares this counter with the one
+ * saved along the thread local environment to know whether it is still
+ * valid.
+ */
+std::atomic<std::uint32_t>  g_fork_generation = 0;
+
+
+void fork_child()
+{
+    g_fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+/** \brief The environment of the current thread.
+ *
+ * The environment of a thread is created once and cached in this thread
+ * local object so the private_logger::create_environment() function does
+ * not have to lock the guard each time a message gets created.
+ *
+ * When the thread exits, the destructor removes the environment from the
+ * private logger map. The environment itself remains valid as long as
+ * messages still reference it.
+ */
+class thread_environment
+{
+public:
+    ~thread_environment()
+    {
+        if(f_environment != nullptr)
+        {
+            private_logger::pointer_t l(f_logger.lock());
+            if(l != nullptr)
+            {
+                l->release_environment(f_environment);
+            }
+        }
+    }
+
+    environment::pointer_t              f_environment = environment::pointer_t();
+    std::weak_ptr<private_logger>       f_logger = std::weak_ptr<private_logger>();
+    std::uint32_t                       f_fork_generation = 0;
+};
+
+
+thread_local thread_environment     g_thread_environment = thread_environment();
+
+
+
 }
 // no name namespace
 
@@ -456,6 +535,10 @@ private_logger::private_logger()
     {
         g_clog_capture = new clog_capture();
     }
+
+    // the thread local environments are not valid in a child process
+    //
+    pthread_atfork(nullptr, nullptr, fork_child);
 }
 
 
@@ -546,7 +629,8 @@ appender::pointer_t private_logger::create_appender(std::string const & type, st
  *
  * \exception invalid_parameter
  * This function raises an invalid_parameter exception when it find an
- * invalid character in the input name.
+ * invalid character in the input name or when the maximum number of
+ * components (component::MAX_COMPONENTS) is reached.
  *
  * \param[in] name  The name of the component to retrieve.
  *
@@ -607,9 +691,43 @@ component::pointer_t private_logger::get_component(std::string const & name)
     //
     //auto comp(std::make_shared<component>(n));
 
-    f_components[n].reset(new component(n));
+    std::size_t const index(f_components.size());
+    if(index >= component::MAX_COMPONENTS)
+    {
+        throw invalid_parameter(
+                  "too many components, cannot create \""
+                + n
+                + "\" (the maximum is "
+                + std::to_string(component::MAX_COMPONENTS)
+                + ").");
+    }
+
+    component::pointer_t comp(new component(n, index));
+    f_components[n] = comp;
+    f_components_by_index[index] = comp;
 
-    return f_components[n];
+    return comp;
+}
+
+
+/** \brief Get a component from its index.
+ *
+ * This function does not lock the guard. A component index can only be
+ * found in a mask after get_component() returned that component, which
+ * happens after the component was saved in the table under the guard.
+ * Components are never removed from the table.
+ *
+ * \param[in] index  The index of the component.
+ *
+ * \return The component or a null pointer if \p index is out of range.
+ */
+component::pointer_t private_logger::get_component_by_index(std::size_t index) const
+{
+    if(index >= f_components_by_index.size())
+    {
+        return component::pointer_t();
+    }
+    return f_components_by_index[index];
 }
 
 
@@ -625,7 +743,7 @@ format::pointer_t private_logger::get_default_format()
 
     if(f_default_format == nullptr)
     {
-        f_default_format = std::make_shared<format>(
+        f_default_format = get_shared_format(
             //"${env:name=HOME:padding='-':align=center:exact_width=6} "
             "${date} ${time}.${time:nanosecond=leadingzeroes} ${hostname}"
             " ${progname}[${pid}/${tid}]: ${severity}:"
@@ -639,21 +757,103 @@ format::pointer_t private_logger::get_default_format()
 }
 
 
+/** \brief Get the environment of the current thread.
+ *
+ * The first time this function gets called by a thread, it creates the
+ * environment of that thread and saves it in a thread local variable.
+ * Further calls return that pointer without locking the guard.
+ *
+ * The environment is also saved in a map so we can keep track of all the
+ * existing environments. When a thread exits, its environment gets removed
+ * from that map (see release_environment()).
+ *
+ * \return A pointer to the environment of the current thread.
+ */
 environment::pointer_t private_logger::create_environment()
 {
-    pid_t const tid(cppthread::gettid());
+    std::uint32_t const fork_generation(g_fork_generation.load(std::memory_order_relaxed));
+    if(g_thread_environment.f_environment != nullptr
+    && g_thread_environment.f_fork_generation == fork_generation)
+    {
+        return g_thread_environment.f_environment;
+    }
 
-    guard g;
+    pid_t const tid(cppthread::gettid());
+    environment::pointer_t result(std::make_shared<environment>(tid));
 
-    auto it(f_environment.find(tid));
-    if(it == f_environment.end())
+    bool report_limit(false);
+    std::size_t over_limit(0);
     {
-        auto result(std::make_shared<environment>(tid));
+        guard g;
+
+        if(f_environment.size() >= g_maximum_environments)
+        {
+            // environments only referenced by the map belong to threads
+            // which are gone
+            //
+            std::erase_if(f_environment, [](auto const & e)
+                {
+                    return e.second.use_count() == 1;
+                });
+
+            if(f_environment.size() >= g_maximum_environments
+            && !f_environment_limit_reported)
+            {
+                f_environment_limit_reported = true;
+                report_limit = true;
+            }
+        }
+
+        // if an entry already exists with the same TID, it is from a
+        // thread which is gone so we can replace it
+        //
         f_environment[tid] = result;
-        return result;
+
+        if(report_limit)
+        {
+            over_limit = f_environment.size();
+        }
     }
 
-    return it->second;
+    g_thread_environment.f_environment = result;
+    g_thread_environment.f_logger = std::dynamic_pointer_cast<private_logger>(shared_from_this());
+    g_thread_environment.f_fork_generation = fork_generation;
+
+    // the thread environment is ready so this message does not come back
+    // here; it is only sent once per logger
+    //
+    if(report_limit)
+    {
+        SNAP_LOG_WARNING
+            << "the logger now keeps "
+            << over_limit
+            << " thread environments which are all in use; the limit of "
+            << g_maximum_environments
+            << " is a soft limit so the map grows beyond it."
+            << SNAP_LOG_SEND;
+    }
+
+    return result;
+}
+
+
+/** \brief Remove the environment of a thread which is exiting.
+ *
+ * This function gets called when a thread exits. It removes that thread
+ * environment from the map of environments so it does not leak.
+ *
+ * \param[in] env  The environment of the thread being terminated.
+ */
+void private_logger::release_environment(environment::pointer_t env)
+{
+    guard g;
+
+    auto it(f_environment.find(env->get_tid()));
+    if(it != f_environment.end()
+    && it->second == env)
+    {
+        f_environment.erase(it);
+    }
 }
 
 
@@ -723,6 +923,8 @@ void private_logger::add_severity(severity::pointer_t sev)
     {
         f_severity_by_name[n] = sev;
     }
+
+    invalidate_severity_table();
 }
 
 
@@ -765,6 +967,8 @@ void private_logger::add_alias(severity::pointer_t sev, std::string const & name
     }
 
     f_severity_by_name[name] = sev;
+
+    invalidate_severity_table();
 }
 
 
@@ -786,15 +990,14 @@ severity::pointer_t private_logger::get_severity(std::string const & name) const
 
 severity::pointer_t private_logger::get_severity(severity_t sev) const
 {
-    guard g;
-
-    auto it(f_severity_by_severity.find(sev));
-    if(it == f_severity_by_severity.end())
+    std::size_t const idx(static_cast<std::size_t>(sev));
+    severity_table_pointer_t const table(get_severity_table());
+    if(idx >= table->size())
     {
         return severity::pointer_t();
     }
 
-    return it->second;
+    return (*table)[idx].f_severity;
 }
 
 
@@ -851,11 +1054,86 @@ severity_by_severity_t private_logger::get_severities_by_severity() const
 }
 
 
+/** \brief Get the table of severities indexed by severity level.
+ *
+ * The table is built the first time it is needed after a change to the
+ * severities. Afterward, this function does not lock anything.
+ *
+ * Each entry includes the name, description, and styles of the severity
+ * as well as the ANSI sequences corresponding to its styles so the
+ * console appender does not have to parse them on each message.
+ *
+ * \return A pointer to the current table of severities.
+ */
+severity_table_pointer_t private_logger::get_severity_table() const
+{
+    severity_table_pointer_t table(f_severity_table.load(std::memory_order_acquire));
+    if(table != nullptr)
+    {
+        return table;
+    }
+
+    guard g;
+
+    table = f_severity_table.load(std::memory_order_relaxed);
+    if(table == nullptr)
+    {
+        std::shared_ptr<severity_table_t> t(std::make_shared<severity_table_t>());
+        for(auto const & s : f_severity_by_severity)
+        {
+            severity_entry & entry((*t)[static_cast<std::size_t>(s.first)]);
+            entry.f_severity = s.second;
+            entry.f_name = s.second->get_name();
+            entry.f_description = s.second->get_description();
+            entry.f_styles = s.second->get_styles();
+            styles_to_ansi(entry.f_styles, entry.f_ansi_style, entry.f_ansi_unstyle);
+        }
+        table = t;
+        f_severity_table.store(table, std::memory_order_release);
+    }
+
+    return table;
+}
+
+
+/** \brief Mark the severity table as out of date.
+ *
+ * This function is called whenever a severity gets added or modified.
+ * The next call to get_severity_table() builds a new table. Threads
+ * which already retrieved the old table can continue to use it.
+ */
+void private_logger::invalidate_severity_table()
+{
+    guard g;
+
+    f_severity_table.store(severity_table_pointer_t(), std::memory_order_release);
+}
+
+
+/** \brief Set a global diagnostic.
+ *
+ * The diagnostics map is never modified in place. A new map is created
+ * and it replaces the old one so messages being rendered on other
+ * threads can continue to use the old map without locking.
+ *
+ * \param[in] key  The name of the diagnostic.
+ * \param[in] diagnostic  The value of the diagnostic.
+ */
 void private_logger::set_diagnostic(std::string const & key, std::string const & diagnostic)
 {
     guard g;
 
-    f_map_diagnostics[key] = diagnostic;
+    map_diagnostics_pointer_t const current(f_map_diagnostics.load());
+    auto const it(current->find(key));
+    if(it != current->end()
+    && it->second == diagnostic)
+    {
+        return;
+    }
+
+    std::shared_ptr<map_diagnostics_t> diagnostics(std::make_shared<map_diagnostics_t>(*current));
+    (*diagnostics)[key] = diagnostic;
+    f_map_diagnostics.store(diagnostics);
 }
 
 
@@ -863,19 +1141,40 @@ void private_logger::unset_diagnostic(std::string const & key)
 {
     guard g;
 
-    auto it(f_map_diagnostics.find(key));
-    if(it != f_map_diagnostics.end())
+    map_diagnostics_pointer_t const current(f_map_diagnostics.load());
+    if(!current->contains(key))
     {
-        f_map_diagnostics.erase(it);
+        return;
     }
+
+    std::shared_ptr<map_diagnostics_t> diagnostics(std::make_shared<map_diagnostics_t>(*current));
+    diagnostics->erase(key);
+    f_map_diagnostics.store(diagnostics);
+}
+
+
+std::string private_logger::get_diagnostic(std::string const & key)
+{
+    map_diagnostics_pointer_t const diagnostics(f_map_diagnostics.load());
+    auto const it(diagnostics->find(key));
+    if(it == diagnostics->end())
+    {
+        return std::string();
+    }
+
+    return it->second;
 }
 
 
 map_diagnostics_t private_logger::get_map_diagnostics()
 {
-    guard g;
+    return *f_map_diagnostics.load();
+}
+
 
-    return f_map_diagnostics;
+map_diagnostics_pointer_t private_logger::get_map_diagnostics_snapshot() const
+{
+    return f_map_diagnostics.load();
 }
 
 
@@ -919,30 +1218,6 @@ trace_diagnostics_t private_logger::get_trace_diagnostics()
 }
 
 
-void private_logger::push_nested_diagnostic(std::string const & diagnostic)
-{
-    guard g;
-
-    f_nested_diagnostics.push_back(diagnostic);
-}
-
-
-void private_logger::pop_nested_diagnostic()
-{
-    guard g;
-
-    f_nested_diagnostics.pop_back();
-}
-
-
-string_vector_t private_logger::get_nested_diagnostics() const
-{
-    guard g;
-
-    return f_nested_diagnostics;
-}
-
-
 void private_logger::register_variable_factory(variable_factory::pointer_t factory)
 {
     guard g;
@@ -987,36 +1262,66 @@ variable::pointer_t private_logger::get_variable(std::string const & type)
 
 bool private_logger::has_functions() const
 {
-    guard g;
-
-    return !f_functions.empty();
+    function_map_pointer_t functions(f_functions.load(std::memory_order_acquire));
+    return functions != nullptr
+        && !functions->empty();
 }
 
 
+/** \brief Register a function.
+ *
+ * The map of functions is read each time a variable with parameters
+ * gets rendered. To avoid locking the guard at that point, the map is
+ * never modified once published. Instead, this function creates a copy
+ * with the new function and publishes that copy.
+ *
+ * The functions of a variable are resolved when its format gets
+ * compiled. The shared formats compiled before this call would ignore
+ * the new function so they get removed from the cache.
+ *
+ * \param[in] func  The function to register.
+ */
 void private_logger::register_function(function::pointer_t func)
 {
-    guard g;
-
-    auto it(f_functions.find(func->get_name()));
-    if(it != f_functions.end())
     {
-        throw duplicate_error(
-                  "trying to add two functions named \""
-                + func->get_name()
-                + "\".");
+        guard g;
+
+        function_map_pointer_t current(f_functions.load(std::memory_order_relaxed));
+        if(current != nullptr
+        && current->contains(func->get_name()))
+        {
+            throw duplicate_error(
+                      "trying to add two functions named \""
+                    + func->get_name()
+                    + "\".");
+        }
+
+        std::shared_ptr<function_map_t> functions(std::make_shared<function_map_t>());
+        if(current != nullptr)
+        {
+            *functions = *current;
+        }
+        (*functions)[func->get_name()] = func;
+        f_functions.store(functions, std::memory_order_release);
     }
-    f_functions[func->get_name()] = func;
+
+    // outside of the guard since compiling a shared format locks the
+    // cache first and then the guard
+    //
+    clear_shared_formats();
 }
 
 
 function::pointer_t private_logger::get_function(std::string const & name) const
 {
-    guard g;
-
-    auto it(f_functions.find(name));
-    if(it != f_functions.end())
+    function_map_pointer_t functions(f_functions.load(std::memory_order_acquire));
+    if(functions != nullptr)
     {
-        return it->second;
+        auto it(functions->find(name));
+        if(it != functions->end())
+        {
+            return it->second;
+        }
     }
 
     return function::pointer_t();
@@ -1027,25 +1332,29 @@ void private_logger::create_thread()
 {
     guard g;
 
+    message_fifo_t::pointer_t fifo;
     try
     {
-        f_fifo = std::make_shared<message_fifo_t>();
-        f_asynchronous_logger = std::make_shared<detail::asynchronous_logger>(f_fifo);
+        fifo = std::make_shared<message_fifo_t>();
+        f_asynchronous_logger = std::make_shared<detail::asynchronous_logger>(fifo);
         f_thread = std::make_shared<cppthread::thread>("asynchronous logger thread", f_asynchronous_logger.get());
         f_thread->start();
     }
     catch(...)                              // LCOV_EXCL_LINE
     {
-        if(f_fifo != nullptr)               // LCOV_EXCL_LINE
+        if(fifo != nullptr)                 // LCOV_EXCL_LINE
         {
-            f_fifo->done(false);            // LCOV_EXCL_LINE
+            fifo->done(false);              // LCOV_EXCL_LINE
         }
 
         f_thread.reset();                   // LCOV_EXCL_LINE
         f_asynchronous_logger.reset();      // LCOV_EXCL_LINE
-        f_fifo.reset();                     // LCOV_EXCL_LINE
         throw;                              // LCOV_EXCL_LINE
     }                                       // LCOV_EXCL_LINE
+
+    // publish the FIFO only once the thread is running
+    //
+    f_fifo.store(fifo, std::memory_order_release);
 }
 
 
@@ -1063,7 +1372,7 @@ void private_logger::delete_thread()
 
         swap(thread,              f_thread);
         swap(asynchronous_logger, f_asynchronous_logger);
-        swap(fifo,                f_fifo);
+        fifo = f_fifo.exchange(message_fifo_t::pointer_t());
     }
 
     if(fifo != nullptr)
@@ -1091,16 +1400,22 @@ void private_logger::delete_thread()
 
 void private_logger::send_message_to_thread(message::pointer_t msg)
 {
+    // the guard is only locked the first time, to create the thread
+    //
+    message_fifo_t::pointer_t fifo(f_fifo.load(std::memory_order_acquire));
+    if(fifo == nullptr)
     {
         guard g;
 
-        if(f_fifo == nullptr)
+        fifo = f_fifo.load(std::memory_order_relaxed);
+        if(fifo == nullptr)
         {
             create_thread();
+            fifo = f_fifo.load(std::memory_order_relaxed);
         }
     }
 
-    f_fifo->push_back(msg);
+    fifo->push_back(msg);
 }
 
 
@@ -47,6 +47,11 @@
 #include    <cppthread/thread.h>
 
 
+// C++
+//
+#include    <array>
+
+
 
 namespace snaplogger
 {
@@ -66,6 +71,7 @@ typedef cppthread::fifo<message::pointer_t>                 message_fifo_t;
 typedef std::map<std::string, appender_factory::pointer_t>  appender_factory_t;
 typedef std::map<pid_t, environment::pointer_t>             environment_map_t;
 typedef std::map<std::string, function::pointer_t>          function_map_t;
+typedef std::shared_ptr<function_map_t const>               function_map_pointer_t;
 typedef std::map<std::string, variable_factory::pointer_t>  variable_factory_map_t;
 typedef std::shared_ptr<detail::asynchronous_logger>        asynchronous_logger_pointer_t;
 
@@ -91,11 +97,13 @@ public:
     appender::pointer_t         create_appender(std::string const & type, std::string const & name);
 
     component::pointer_t        get_component(std::string const & name);
+    component::pointer_t        get_component_by_index(std::size_t index) const;
     component::map_t            get_component_list() const;
 
     format::pointer_t           get_default_format();
 
     environment::pointer_t      create_environment();
+    void                        release_environment(environment::pointer_t env);
 
     void                        add_severity(severity::pointer_t sev);
     void                        add_alias(severity::pointer_t sev, std::string const & name);
@@ -105,10 +113,14 @@ public:
     void                        set_default_severity(severity::pointer_t sev);
     severity_by_name_t          get_severities_by_name() const;
     severity_by_severity_t      get_severities_by_severity() const;
+    severity_table_pointer_t    get_severity_table() const;
+    void                        invalidate_severity_table();
 
     void                        set_diagnostic(std::string const & key, std::string const & diagnostic);
     void                        unset_diagnostic(std::string const & key);
+    std::string                 get_diagnostic(std::string const & key);
     map_diagnostics_t           get_map_diagnostics();
+    map_diagnostics_pointer_t   get_map_diagnostics_snapshot() const;
 
     void                        set_maximum_trace_diagnostics(size_t max);
     size_t                      get_maximum_trace_diagnostics() const;
@@ -116,10 +128,6 @@ public:
     void                        clear_trace_diagnostics();
     trace_diagnostics_t         get_trace_diagnostics();
 
-    void                        push_nested_diagnostic(std::string const & diagnostic);
-    void                        pop_nested_diagnostic();
-    string_vector_t             get_nested_diagnostics() const;
-
     void                        register_variable_factory(variable_factory::pointer_t factory);
     variable::pointer_t         get_variable(std::string const & type);
 
@@ -139,21 +147,28 @@ private:
 
     appender_factory_t          f_appender_factories = appender_factory_t();
     component::map_t            f_components = component::map_t();
+    std::array<component::pointer_t, component::MAX_COMPONENTS>
+                                f_components_by_index = {};
     format::pointer_t           f_default_format = format::pointer_t();
     environment_map_t           f_environment = environment_map_t();
+    bool                        f_environment_limit_reported = false;
     severity_by_severity_t      f_severity_by_severity = severity_by_severity_t();
     severity_by_name_t          f_severity_by_name = severity_by_name_t();
     severity::pointer_t         f_default_severity = severity::pointer_t();
-    map_diagnostics_t           f_map_diagnostics = map_diagnostics_t();
+    mutable std::atomic<severity_table_pointer_t>
+                                f_severity_table = severity_table_pointer_t();
+    std::atomic<map_diagnostics_pointer_t>
+                                f_map_diagnostics = std::make_shared<map_diagnostics_t const>();
     trace_diagnostics_t         f_trace_diagnostics = trace_diagnostics_t();
     std::size_t                 f_maximum_trace_diagnostics = DIAG_TRACE_SIZE;
-    string_vector_t             f_nested_diagnostics = string_vector_t();
-    function_map_t              f_functions = function_map_t();
+    std::atomic<function_map_pointer_t>
+                                f_functions = function_map_pointer_t();
     variable_factory_map_t      f_variable_factories = variable_factory_map_t();
 
     // thread handling
     //
-    message_fifo_t::pointer_t       f_fifo = message_fifo_t::pointer_t();
+    std::atomic<message_fifo_t::pointer_t>
+                                    f_fifo = message_fifo_t::pointer_t();
     asynchronous_logger_pointer_t   f_asynchronous_logger = asynchronous_logger_pointer_t();
     cppthread::thread::pointer_t    f_thread = cppthread::thread::pointer_t();   // <--- MUST REMAIN LAST VARIABLE MEMBER
 };
@@ -48,6 +48,7 @@
 
 // C++
 //
+#include    <atomic>
 #include    <iostream>
 #include    <map>
 
@@ -72,7 +73,8 @@ namespace
 {
 
 
-bool        g_severity_auto_added = false;
+std::atomic<bool>   g_severity_auto_added = false;
+bool                g_severity_auto_adding = false;
 
 
 struct system_severity
@@ -315,13 +317,21 @@ advgetopt::options_environment g_config_option =
  */
 void auto_add_severities()
 {
+    if(g_severity_auto_added.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
     guard g;
 
-    if(g_severity_auto_added)
+    // the adding flag prevents recursive calls from this very function
+    //
+    if(g_severity_auto_adding
+    || g_severity_auto_added.load(std::memory_order_relaxed))
     {
         return;
     }
-    g_severity_auto_added = true;
+    g_severity_auto_adding = true;
 
     private_logger::pointer_t l(get_private_logger());
 
@@ -477,6 +487,8 @@ void auto_add_severities()
             }
         }
     }
+
+    g_severity_auto_added.store(true, std::memory_order_release);
 }
 
 
@@ -489,6 +501,7 @@ void auto_add_severities()
 
 severity::severity(severity_t sev, std::string const & name, bool system)
     : f_severity(sev)
+    , f_name(name)
     , f_names(string_vector_t({name}))
     , f_system(system)
 {
@@ -563,9 +576,16 @@ bool severity::is_registered() const
 }
 
 
-std::string severity::get_name() const
+/** \brief Get the name of this severity.
+ *
+ * This is the first name given to the severity. The aliases are not
+ * included. Use get_all_names() to get the aliases.
+ *
+ * \return A reference to the name of this severity.
+ */
+std::string const & severity::get_name() const
 {
-    return f_names[0];
+    return f_name;
 }
 
 
@@ -613,12 +633,21 @@ string_vector_t severity::get_all_names() const
 
 void severity::set_description(std::string const & description)
 {
+    guard g;
+
     f_description = description;
+
+    if(is_registered())
+    {
+        get_private_logger()->invalidate_severity_table();
+    }
 }
 
 
 std::string severity::get_description() const
 {
+    guard g;
+
     if(f_description.empty())
     {
         return get_name();
@@ -629,12 +658,21 @@ std::string severity::get_description() const
 
 void severity::set_styles(std::string const & styles)
 {
+    guard g;
+
     f_styles = styles;
+
+    if(is_registered())
+    {
+        get_private_logger()->invalidate_severity_table();
+    }
 }
 
 
 std::string severity::get_styles() const
 {
+    guard g;
+
     return f_styles;
 }
 
@@ -689,6 +727,28 @@ severity_by_severity_t get_severities_by_severity()
 }
 
 
+/** \brief Get the table of severities.
+ *
+ * The table has one entry per severity level. It can be used without
+ * locking anything. The entries remain valid as long as the returned
+ * pointer is kept, even if the severities get modified in the meantime.
+ *
+ * \return A pointer to the current severity table.
+ */
+severity_table_pointer_t get_severity_table()
+{
+    auto_add_severities();
+    return get_private_logger()->get_severity_table();
+}
+
+
+severity_table_pointer_t get_severity_table(message const & msg)
+{
+    auto_add_severities();
+    return get_private_logger(msg)->get_severity_table();
+}
+
+
 
 } // snaplogger namespace
 
@@ -39,6 +39,7 @@
 
 // C++
 //
+#include    <array>
 #include    <memory>
 
 
@@ -107,7 +108,7 @@ public:
     void                mark_as_registered();
     bool                is_registered() const;
 
-    std::string         get_name() const;
+    std::string const & get_name() const;
     void                add_alias(std::string const & name);
     string_vector_t     get_all_names() const;
 
@@ -119,6 +120,7 @@ public:
 
 private:
     severity_t const    f_severity;
+    std::string const   f_name;
     string_vector_t     f_names = string_vector_t();
     bool const          f_system;
     bool                f_registered = false;
@@ -129,6 +131,30 @@ private:
 typedef std::map<severity_t, severity::pointer_t>   severity_by_severity_t;
 typedef std::map<std::string, severity::pointer_t>  severity_by_name_t;
 
+
+/** \brief The information about one severity level.
+ *
+ * The severity table has one entry per severity level. When no severity
+ * is defined at that level, f_severity is a null pointer and the strings
+ * are empty.
+ *
+ * The entries never change once the table was published. A change to
+ * the severities creates a new table instead.
+ */
+struct severity_entry
+{
+    severity::pointer_t f_severity = severity::pointer_t();
+    std::string         f_name = std::string();
+    std::string         f_description = std::string();
+    std::string         f_styles = std::string();
+    std::string         f_ansi_style = std::string();
+    std::string         f_ansi_unstyle = std::string();
+};
+
+typedef std::array<severity_entry, static_cast<std::size_t>(severity_t::SEVERITY_MAX) + 1>
+                                                    severity_table_t;
+typedef std::shared_ptr<severity_table_t const>     severity_table_pointer_t;
+
 void                    add_severity(severity::pointer_t sev);
 severity::pointer_t     get_severity(std::string const & name);
 severity::pointer_t     get_severity(message const & msg, std::string const & name);
@@ -136,13 +162,18 @@ severity::pointer_t     get_severity(severity_t sev);
 severity::pointer_t     get_severity(message const & msg, severity_t sev);
 severity_by_name_t      get_severities_by_name();
 severity_by_severity_t  get_severities_by_severity();
+severity_table_pointer_t
+                        get_severity_table();
+severity_table_pointer_t
+                        get_severity_table(message const & msg);
 
 template<typename CharT, typename Traits>
 inline std::basic_ostream<CharT, Traits> &
 operator << (std::basic_ostream<CharT, Traits> & os, severity_t sev)
 {
-    severity::pointer_t s(get_severity(sev));
-    if(s == nullptr)
+    severity_table_pointer_t const table(get_severity_table());
+    severity_entry const & entry((*table)[static_cast<std::size_t>(sev)]);
+    if(entry.f_severity == nullptr)
     {
         os << "(unknown severity: "
            << static_cast<int>(sev)
@@ -150,7 +181,7 @@ operator << (std::basic_ostream<CharT, Traits> & os, severity_t sev)
     }
     else
     {
-        os << s->get_name();
+        os << entry.f_name;
     }
     return os;
 }
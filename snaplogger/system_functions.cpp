@@ -93,14 +93,34 @@ namespace
 //
 
 
-DECLARE_FUNCTION(padding)
+DECLARE_CHECKED_FUNCTION(padding)
 {
     snapdev::NOT_USED(msg);
 
-    std::u32string pad;
+    // check_param() verified that we have exactly one character
+    //
     if(p->get_type() == param::type_t::TYPE_STRING)
     {
-        pad = libutf8::to_u32string(p->get_value());
+        d.set_param(std::string("padding"), p->get_value());
+    }
+    else
+    {
+        d.set_param(std::string("padding"), std::to_string(p->get_integer()));
+    }
+}
+
+
+CHECK_FUNCTION(padding)
+{
+    if(p->get_type() == param::type_t::TYPE_STRING)
+    {
+        if(libutf8::to_u32string(p->get_value()).length() != 1)
+        {
+            throw invalid_parameter(
+                      "the ${...:padding=' '} must be exactly one character, not \""
+                    + p->get_value()
+                    + "\".");
+        }
     }
     else
     {
@@ -112,26 +132,16 @@ DECLARE_FUNCTION(padding)
                     + std::to_string(digit)
                     + "\".");
         }
-        pad = libutf8::to_u32string(std::to_string(digit));
-    }
-    if(pad.length() == 1)
-    {
-        d.set_param(std::string("padding"), pad);
-    }
-    else
-    {
-        throw invalid_parameter(
-                  "the ${...:padding=' '} must be exactly one character, not \""
-                + p->get_value()
-                + "\".");
     }
 }
 
 
-DECLARE_FUNCTION(align)
+DECLARE_CHECKED_FUNCTION(align)
 {
     snapdev::NOT_USED(msg);
 
+    // check_param() verified that the value is one of these three
+    //
     if(p->get_value() == "left")
     {
         d.set_param("align", "L");
@@ -140,11 +150,18 @@ DECLARE_FUNCTION(align)
     {
         d.set_param("align", "R");
     }
-    else if(p->get_value() == "center")
+    else
     {
         d.set_param("align", "C");
     }
-    else
+}
+
+
+CHECK_FUNCTION(align)
+{
+    if(p->get_value() != "left"
+    && p->get_value() != "right"
+    && p->get_value() != "center")
     {
         throw invalid_parameter("the ${...:align=left|center|right} was expected, got \""
                               + p->get_value()
@@ -161,7 +178,7 @@ DECLARE_FUNCTION(align)
 //
 
 
-DECLARE_FUNCTION(max_width)
+DECLARE_CHECKED_FUNCTION(max_width)
 {
     snapdev::NOT_USED(msg);
 
@@ -186,7 +203,15 @@ DECLARE_FUNCTION(max_width)
 }
 
 
-DECLARE_FUNCTION(min_width)
+CHECK_FUNCTION(max_width)
+{
+    // the width must be an integer
+    //
+    snapdev::NOT_USED(p->get_integer());
+}
+
+
+DECLARE_CHECKED_FUNCTION(min_width)
 {
     snapdev::NOT_USED(msg);
 
@@ -221,7 +246,15 @@ DECLARE_FUNCTION(min_width)
 }
 
 
-DECLARE_FUNCTION(exact_width)
+CHECK_FUNCTION(min_width)
+{
+    // the width must be an integer
+    //
+    snapdev::NOT_USED(p->get_integer());
+}
+
+
+DECLARE_CHECKED_FUNCTION(exact_width)
 {
     snapdev::NOT_USED(msg);
 
@@ -274,10 +307,18 @@ DECLARE_FUNCTION(exact_width)
 }
 
 
+CHECK_FUNCTION(exact_width)
+{
+    // the width must be an integer
+    //
+    snapdev::NOT_USED(p->get_integer());
+}
 
 
 
-DECLARE_FUNCTION(append)
+
+
+DECLARE_CHECKED_FUNCTION(append)
 {
     snapdev::NOT_USED(msg);
 
@@ -286,7 +327,15 @@ DECLARE_FUNCTION(append)
     d.get_value() += str;
 }
 
-DECLARE_FUNCTION(prepend)
+
+CHECK_FUNCTION(append)
+{
+    // the parameter must be a string
+    //
+    snapdev::NOT_USED(p->get_value());
+}
+
+DECLARE_CHECKED_FUNCTION(prepend)
 {
     snapdev::NOT_USED(msg);
 
@@ -296,10 +345,18 @@ DECLARE_FUNCTION(prepend)
 }
 
 
+CHECK_FUNCTION(prepend)
+{
+    // the parameter must be a string
+    //
+    snapdev::NOT_USED(p->get_value());
+}
+
+
 
 
 
-DECLARE_FUNCTION(escape)
+DECLARE_CHECKED_FUNCTION(escape)
 {
     snapdev::NOT_USED(msg);
 
@@ -379,6 +436,14 @@ DECLARE_FUNCTION(escape)
 }
 
 
+CHECK_FUNCTION(escape)
+{
+    // the parameter must be a string
+    //
+    snapdev::NOT_USED(p->get_value());
+}
+
+
 
 
 
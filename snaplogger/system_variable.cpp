@@ -60,7 +60,7 @@ namespace
 
 DEFINE_LOGGER_VARIABLE(hostname)
 {
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
@@ -80,9 +80,25 @@ DEFINE_LOGGER_VARIABLE(hostname)
 }
 
 
-DEFINE_LOGGER_VARIABLE(hostbyname)
+DEFINE_COMPILED_LOGGER_VARIABLE(hostbyname, std::string)
 {
-    auto params(get_params());
+    hostent * h(gethostbyname(f_plan.c_str()));
+    if(h != nullptr)
+    {
+        value += h->h_name;
+    }
+    else
+    {
+        value += "<host " + f_plan + " not found>";
+    }
+
+    variable::process_value(msg, value);
+}
+
+
+COMPILE_LOGGER_VARIABLE(hostbyname)
+{
+    auto const & params(get_params());
     if(params.empty())
     {
         throw invalid_variable("the ${hostbyname:...} variable must have a name parameter.");
@@ -91,28 +107,17 @@ DEFINE_LOGGER_VARIABLE(hostbyname)
     {
         throw invalid_variable("the ${hostbyname:...} variable first parameter must be its name parameter.");
     }
-    auto hostname(params[0]->get_value());
-    if(hostname.empty())
+    f_plan = params[0]->get_value();
+    if(f_plan.empty())
     {
         throw invalid_variable("the ${hostbyname:...} variable first parameter must be its non-empty name.");
     }
-    hostent * h(gethostbyname(hostname.c_str()));
-    if(h != nullptr)
-    {
-        value += h->h_name;
-    }
-    else
-    {
-        value += "<host " + std::string(h->h_name) + " not found>";
-    }
-
-    variable::process_value(msg, value);
 }
 
 
 DEFINE_LOGGER_VARIABLE(domainname)
 {
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
@@ -134,7 +139,7 @@ DEFINE_LOGGER_VARIABLE(domainname)
 
 DEFINE_LOGGER_VARIABLE(boot_id)
 {
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
@@ -151,7 +156,7 @@ DEFINE_LOGGER_VARIABLE(boot_id)
 
 DEFINE_LOGGER_VARIABLE(pid)
 {
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
@@ -168,7 +173,7 @@ DEFINE_LOGGER_VARIABLE(pid)
 
 DEFINE_LOGGER_VARIABLE(tid)
 {
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
@@ -185,7 +190,7 @@ DEFINE_LOGGER_VARIABLE(tid)
 
 DEFINE_LOGGER_VARIABLE(threadname)
 {
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
@@ -193,10 +198,10 @@ DEFINE_LOGGER_VARIABLE(threadname)
         // "threadname"; this is going to be automatic in our own snap_thread
         // implementation, any others would have to be done manually
         //
-        map_diagnostics_t diag(get_map_diagnostics());
+        map_diagnostics_pointer_t const diagnostics(get_map_diagnostics_snapshot());
         std::string const tid(std::to_string(cppthread::gettid()));
-        auto it(diag.find("threadname#" + tid));
-        if(it != diag.end())
+        auto it(diagnostics->find("threadname#" + tid));
+        if(it != diagnostics->end())
         {
             value += it->second;
         }
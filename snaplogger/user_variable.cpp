@@ -69,7 +69,7 @@ namespace
 
 DEFINE_LOGGER_VARIABLE(uid)
 {
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
@@ -86,25 +86,22 @@ DEFINE_LOGGER_VARIABLE(uid)
 
 DEFINE_LOGGER_VARIABLE(username)
 {
-    uid_t uid;
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
-        uid = getuid();
+        char buf[1024];
+        passwd pw;
+        passwd * pw_ptr(nullptr);
+        if(getpwuid_r(getuid(), &pw, buf, sizeof(buf), &pw_ptr) == 0
+        && pw_ptr == &pw)
+        {
+            value += pw.pw_name;
+        }
     }
     else
     {
-        uid = msg.get_environment()->get_uid();
-    }
-
-    char buf[1024];
-    passwd pw;
-    passwd * pw_ptr(nullptr);
-    if(getpwuid_r(uid, &pw, buf, sizeof(buf), &pw_ptr) == 0
-    && pw_ptr == &pw)
-    {
-        value += pw.pw_name;
+        value += msg.get_environment()->get_username();
     }
 
     variable::process_value(msg, value);
@@ -113,7 +110,7 @@ DEFINE_LOGGER_VARIABLE(username)
 
 DEFINE_LOGGER_VARIABLE(gid)
 {
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
@@ -130,25 +127,22 @@ DEFINE_LOGGER_VARIABLE(gid)
 
 DEFINE_LOGGER_VARIABLE(groupname)
 {
-    gid_t gid;
-    auto params(get_params());
+    auto const & params(get_params());
     if(params.size() > 0
     && params[0]->get_name() == "running")
     {
-        gid = getgid();
+        char buf[1024];
+        group gr;
+        group * gr_ptr(nullptr);
+        if(getgrgid_r(getgid(), &gr, buf, sizeof(buf), &gr_ptr) == 0
+        && gr_ptr == &gr)
+        {
+            value += gr.gr_name;
+        }
     }
     else
     {
-        gid = msg.get_environment()->get_gid();
-    }
-
-    char buf[1024];
-    group gr;
-    group * gr_ptr(nullptr);
-    if(getgrgid_r(gid, &gr, buf, sizeof(buf), &gr_ptr) == 0
-    && gr_ptr == &gr)
-    {
-        value += gr.gr_name;
+        value += msg.get_environment()->get_groupname();
     }
 
     variable::process_value(msg, value);
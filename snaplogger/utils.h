@@ -28,6 +28,7 @@
 //
 #include    <map>
 #include    <string>
+#include    <utility>
 #include    <vector>
 
 
@@ -44,6 +45,8 @@ namespace snaplogger
 typedef std::map<std::string, std::string>      string_map_t;
 typedef std::map<std::string, std::u32string>   u8u32string_map_t;
 typedef std::vector<std::string>                string_vector_t;
+typedef std::vector<std::pair<std::string, std::string>>
+                                                context_diagnostics_t;
 
 
 bool        is_rotational(std::string const & filename);
@@ -53,7 +53,6 @@
 #include    "snaplogger/variable.h"
 
 #include    "snaplogger/exception.h"
-#include    "snaplogger/guard.h"
 #include    "snaplogger/private_logger.h"
 
 
@@ -87,22 +86,27 @@ namespace
 
 
 
-DEFINE_LOGGER_VARIABLE(direct)
+DEFINE_COMPILED_LOGGER_VARIABLE(direct, std::string)
 {
     snapdev::NOT_USED(msg);
 
-    // insert all our parameters as is
+    // do NOT apply parameters further, the user has no access to those
+    // anyway; this is the direct text we find in between variables
     //
+    value += f_plan;
+}
+
+
+COMPILE_LOGGER_VARIABLE(direct)
+{
+    // the literal text is all our parameters as is
+    //
+    f_plan.clear();
     for(auto const & p : get_params())
     {
         // TODO: should we add a space too? or can we have spaces in the params?
-        value += p->get_value();
+        f_plan += p->get_value();
     }
-
-    // do NOT apply parameters further, the user has no access to those
-    // anyway; this is the direct text we find in between variables
-    //
-    //variable::process_value(msg, value);
 }
 
 
@@ -201,44 +205,119 @@ variable::~variable()
 }
 
 
+/** \brief Add a parameter to this variable.
+ *
+ * Parameters are added while the format gets parsed. If the name of
+ * the parameter matches a registered function, that function gets
+ * resolved here, once, instead of being searched by name each time a
+ * message is rendered. This means functions must be registered before
+ * the formats using them get parsed.
+ *
+ * Once all the parameters were added, call compile(). A variable is not
+ * modified after that so the parameters and functions can be read
+ * without a lock.
+ *
+ * \param[in] p  The parameter to add.
+ */
 void variable::add_param(param::pointer_t p)
 {
-    guard g;
-
     f_params.push_back(p);
+
+    function::pointer_t func(get_private_logger()->get_function(p->get_name()));
+    if(func != nullptr)
+    {
+        f_functions.push_back(applied_function_t{ func, p });
+    }
+    // else -- ignore missing functions
 }
 
 
-param::vector_t variable::get_params() const
+param::vector_t const & variable::get_params() const
 {
-    guard g;
-
     return f_params;
 }
 
 
-std::string variable::get_value(message const & msg) const
+/** \brief Validate and decode the parameters of this variable.
+ *
+ * The format calls this function once it parsed all the parameters of
+ * the variable. It lets each function check its parameter and then
+ * each variable decode its own parameters with compile_params().
+ *
+ * Errors are reported by throwing an exception so an invalid format is
+ * detected when it gets loaded instead of each time a message is
+ * rendered.
+ */
+void variable::compile()
 {
-    guard g;
+    for(auto const & f : f_functions)
+    {
+        f.f_function->check_param(f.f_param);
+    }
+
+    compile_params();
+}
+
 
+/** \brief Decode the parameters of this variable.
+ *
+ * By default a variable has nothing to decode. The variables defined
+ * with DEFINE_COMPILED_LOGGER_VARIABLE() implement this function to
+ * transform their parameters in a plan used by process_value().
+ */
+void variable::compile_params()
+{
+}
+
+
+std::string variable::get_value(message const & msg) const
+{
     std::string value;
     process_value(msg, value);
     return value;
 }
 
 
-void variable::process_value(message const & msg, std::string & value) const
+/** \brief Append the value of this variable to \p output.
+ *
+ * Variables append their value to the string they receive. When no
+ * function applies to this variable, the value is therefore appended
+ * directly to \p output without any intermediate string.
+ *
+ * The functions transform the whole string they receive so when this
+ * variable has functions, the value is first rendered on its own.
+ *
+ * \param[in] msg  The message being rendered.
+ * \param[in,out] output  The string where the value gets appended.
+ */
+void variable::append_value(message const & msg, std::string & output) const
 {
-    auto l(get_private_logger(msg));
-
+    if(f_functions.empty())
     {
-        guard g;
+        process_value(msg, output);
+        return;
+    }
+
+    std::string value;
+    process_value(msg, value);
+    output += value;
+}
 
-        if(!l->has_functions())
-        {
-            // no functions available, we're done
-            return;     // LCOV_EXCL_LINE
-        }
+
+/** \brief Apply the functions of this variable to its value.
+ *
+ * The value is only converted to UTF-32 when at least one of the
+ * parameters of this variable is a function. Otherwise it is returned
+ * as is.
+ *
+ * \param[in] msg  The message being rendered.
+ * \param[in,out] value  The value to transform.
+ */
+void variable::process_value(message const & msg, std::string & value) const
+{
+    if(f_functions.empty())
+    {
+        return;
     }
 
     function_data d;
@@ -258,15 +337,9 @@ void variable::process_value(message const & msg, std::string & value) const
         return;
     }
 
-    for(auto p : f_params)
+    for(auto const & f : f_functions)
     {
-        std::string const & name(p->get_name());
-        auto func(l->get_function(name));
-        if(func != nullptr)
-        {
-            func->apply(msg, d, p);
-        }
-        // else -- ignore missing functions
+        f.f_function->apply(msg, d, f.f_param);
     }
 
     value = libutf8::to_u8string(d.get_value());
@@ -387,11 +460,23 @@ std::string const & function::get_name() const
 }
 
 
+/** \brief Check the parameter of this function.
+ *
+ * This function is called once, when the format using the function gets
+ * parsed. By default, any parameter is accepted. Functions declared with
+ * DECLARE_CHECKED_FUNCTION() throw if \p p is not valid.
+ *
+ * \param[in] p  The parameter of this function.
+ */
+void function::check_param(param::pointer_t const & p) const
+{
+    snapdev::NOT_USED(p);
+}
+
+
 
 void register_function(function::pointer_t func)
 {
-    guard g;
-
     get_private_logger()->register_function(func);
 }
 
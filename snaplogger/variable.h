@@ -195,6 +195,9 @@ operator << (std::basic_ostream<CharT, Traits> & os, param::type_t t)
 
 
 
+class function;
+
+
 class variable
 {
 public:
@@ -205,14 +208,29 @@ public:
 
     virtual bool        ignore_on_no_repeat() const = 0;
     void                add_param(param::pointer_t p);
-    param::vector_t     get_params() const;
+    param::vector_t const &
+                        get_params() const;
+    void                compile();
     std::string         get_value(message const & msg) const;
+    void                append_value(message const & msg, std::string & output) const;
 
 protected:
+    virtual void        compile_params();
     virtual void        process_value(message const & msg, std::string & value) const;
 
 private:
+    struct applied_function_t
+    {
+        std::shared_ptr<function>
+                        f_function = std::shared_ptr<function>();
+        param::pointer_t
+                        f_param = param::pointer_t();
+    };
+    typedef std::vector<applied_function_t>     applied_function_vector_t;
+
     param::vector_t     f_params = param::vector_t();
+    applied_function_vector_t
+                        f_functions = applied_function_vector_t();
 };
 
 
@@ -236,17 +254,7 @@ void                    register_variable_factory(variable_factory::pointer_t fa
 variable::pointer_t     get_variable(std::string const & type);
 
 
-#define DEFINE_LOGGER_VARIABLE_IMPL_(type, do_ignore_on_no_repeat)  \
-    class type##_variable                                           \
-        : public ::snaplogger::variable                             \
-    {                                                               \
-    protected:                                                      \
-        virtual bool ignore_on_no_repeat() const override           \
-        { return do_ignore_on_no_repeat; }                          \
-        virtual void process_value(                                 \
-                  ::snaplogger::message const & msg                 \
-                , std::string & value) const override;              \
-    };                                                              \
+#define DEFINE_LOGGER_VARIABLE_FACTORY_(type)                       \
     class type##_variable_factory final                             \
         : public ::snaplogger::variable_factory                     \
     {                                                               \
@@ -266,7 +274,20 @@ variable::pointer_t     get_variable(std::string const & type);
                     (std::make_shared<                              \
                         type##_variable_factory>());                \
             return 0;                                               \
-        } ();                                                       \
+        } ();
+
+#define DEFINE_LOGGER_VARIABLE_IMPL_(type, do_ignore_on_no_repeat)  \
+    class type##_variable                                           \
+        : public ::snaplogger::variable                             \
+    {                                                               \
+    protected:                                                      \
+        virtual bool ignore_on_no_repeat() const override           \
+        { return do_ignore_on_no_repeat; }                          \
+        virtual void process_value(                                 \
+                  ::snaplogger::message const & msg                 \
+                , std::string & value) const override;              \
+    };                                                              \
+    DEFINE_LOGGER_VARIABLE_FACTORY_(type)                           \
     void type##_variable::process_value(                            \
                   ::snaplogger::message const & msg                 \
                 , std::string & value) const
@@ -279,6 +300,40 @@ variable::pointer_t     get_variable(std::string const & type);
     DEFINE_LOGGER_VARIABLE_IMPL_(type, true)
 
 
+// a compiled variable decodes its parameters once, in its
+// COMPILE_LOGGER_VARIABLE() function, and saves the result in a
+// structure of type `plan` which process_value() then reads as f_plan
+//
+#define DEFINE_COMPILED_LOGGER_VARIABLE_IMPL_(type, plan, do_ignore_on_no_repeat) \
+    class type##_variable                                           \
+        : public ::snaplogger::variable                             \
+    {                                                               \
+    protected:                                                      \
+        virtual bool ignore_on_no_repeat() const override           \
+        { return do_ignore_on_no_repeat; }                          \
+        virtual void compile_params() override;                     \
+        virtual void process_value(                                 \
+                  ::snaplogger::message const & msg                 \
+                , std::string & value) const override;              \
+    private:                                                        \
+        plan f_plan = plan();                                       \
+    };                                                              \
+    DEFINE_LOGGER_VARIABLE_FACTORY_(type)                           \
+    void type##_variable::process_value(                            \
+                  ::snaplogger::message const & msg                 \
+                , std::string & value) const
+
+
+#define DEFINE_COMPILED_LOGGER_VARIABLE(type, plan) \
+    DEFINE_COMPILED_LOGGER_VARIABLE_IMPL_(type, plan, false)
+
+#define DEFINE_COMPILED_LOGGER_VARIABLE_IGNORED_ON_NO_REPEAT(type, plan) \
+    DEFINE_COMPILED_LOGGER_VARIABLE_IMPL_(type, plan, true)
+
+#define COMPILE_LOGGER_VARIABLE(type) \
+    void type##_variable::compile_params()
+
+
 
 
 
@@ -311,6 +366,7 @@ public:
 
     std::string const & get_name() const;
 
+    virtual void        check_param(param::pointer_t const & p) const;
     virtual void        apply(
                               message const & msg
                             , function_data & data
@@ -344,6 +400,35 @@ void register_function(function::pointer_t func);
             , ::snaplogger::param::pointer_t const & p)
 
 
+// a checked function validates its parameter when the format gets
+// parsed in its CHECK_FUNCTION() function instead of on each message
+//
+#define DECLARE_CHECKED_FUNCTION(name)                                      \
+    class name##_function : public function                                 \
+    {                                                                       \
+    public:                                                                 \
+        name##_function() : function(#name) {}                              \
+        virtual void check_param(                                           \
+              ::snaplogger::param::pointer_t const & p) const override;     \
+        virtual void apply(                                                 \
+              ::snaplogger::message const & msg                             \
+            , ::snaplogger::function_data & d                               \
+            , ::snaplogger::param::pointer_t const & p) override;           \
+    };                                                                      \
+    int __attribute__((unused)) g_##name##_function = []() {                \
+            register_function(std::make_shared<name##_function>());         \
+            return 0;                                                       \
+        } ();                                                               \
+    void name##_function::apply(                                            \
+              ::snaplogger::message const & msg                             \
+            , ::snaplogger::function_data & d                               \
+            , ::snaplogger::param::pointer_t const & p)
+
+#define CHECK_FUNCTION(name)                                                \
+    void name##_function::check_param(                                      \
+              ::snaplogger::param::pointer_t const & p) const
+
+
 
 
 
@@ -33,6 +33,18 @@
 #include    <snaplogger/version.h>
 
 
+// snapdev
+//
+#include    <snapdev/not_used.h>
+
+
+// C++
+//
+#include    <set>
+#include    <sstream>
+#include    <thread>
+
+
 // C
 //
 #include    <unistd.h>
@@ -43,6 +55,39 @@
 
 
 
+namespace
+{
+
+
+
+class failing_appender
+    : public snaplogger::appender
+{
+public:
+    failing_appender(std::string const & name)
+        : appender(name, "failing")
+    {
+    }
+
+protected:
+    virtual bool process_message(snaplogger::message const & msg, std::string const & formatted_message) override
+    {
+        snapdev::NOT_USED(msg, formatted_message);
+        ++f_count;
+        return false;
+    }
+
+public:
+    int f_count = 0;
+};
+
+
+
+}
+// no name namespace
+
+
+
 CATCH_TEST_CASE("appender", "[appender]")
 {
     CATCH_START_SECTION("appender: create")
@@ -153,6 +198,94 @@ CATCH_TEST_CASE("appender", "[appender]")
         l->reset();
     }
     CATCH_END_SECTION()
+
+    CATCH_START_SECTION("appender: a fallback receives a message only once")
+    {
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${message}"));
+
+        std::shared_ptr<failing_appender> failing(std::make_shared<failing_appender>("failing"));
+        failing->set_format(f);
+        snaplogger::buffer_appender::pointer_t backup(std::make_shared<snaplogger::buffer_appender>("backup"));
+        backup->set_format(f);
+
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        l->add_appender(failing);
+        l->add_appender(backup);
+
+        // an unknown fallback is ignored
+        //
+        CATCH_REQUIRE(failing->add_fallback_appender("unknown"));
+        CATCH_REQUIRE(failing->add_fallback_appender("backup"));
+        CATCH_REQUIRE_FALSE(failing->add_fallback_appender("backup"));
+
+        SNAP_LOG_ERROR << "sent to the fallback" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(failing->f_count == 1);
+        CATCH_REQUIRE(backup->str() == "sent to the fallback\n");
+
+        // without the fallback, the backup gets the message as a main appender
+        //
+        CATCH_REQUIRE(failing->remove_fallback_appender("backup"));
+        CATCH_REQUIRE_FALSE(failing->remove_fallback_appender("backup"));
+        backup->clear();
+
+        SNAP_LOG_ERROR << "sent directly" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(failing->f_count == 2);
+        CATCH_REQUIRE(backup->str() == "sent directly\n");
+
+        l->reset();
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("appender: threads log in parallel")
+    {
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("parallel-buffer"));
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${message}"));
+        buffer->set_format(f);
+
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        l->add_appender(buffer);
+
+        constexpr int const thread_count = 8;
+        constexpr int const message_count = 250;
+
+        std::vector<std::thread> threads;
+        for(int t(0); t < thread_count; ++t)
+        {
+            threads.emplace_back([t]()
+                {
+                    for(int i(0); i < message_count; ++i)
+                    {
+                        SNAP_LOG_ERROR << "thread " << t << " message " << i << SNAP_LOG_SEND;
+                    }
+                });
+        }
+        for(auto & th : threads)
+        {
+            th.join();
+        }
+
+        // each message must be output whole, exactly once
+        //
+        std::set<std::string> expected;
+        for(int t(0); t < thread_count; ++t)
+        {
+            for(int i(0); i < message_count; ++i)
+            {
+                expected.insert("thread " + std::to_string(t) + " message " + std::to_string(i));
+            }
+        }
+        std::set<std::string> found;
+        std::string line;
+        std::istringstream in(buffer->str());
+        while(std::getline(in, line))
+        {
+            CATCH_REQUIRE(found.insert(line).second);
+        }
+        CATCH_REQUIRE(found == expected);
+
+        l->reset();
+    }
+    CATCH_END_SECTION()
 }
 
 
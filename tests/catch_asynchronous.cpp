@@ -27,6 +27,7 @@
 #include    <snaplogger/logger.h>
 #include    <snaplogger/map_diagnostic.h>
 #include    <snaplogger/message.h>
+#include    <snaplogger/nested_diagnostic.h>
 
 
 // C
@@ -95,6 +96,118 @@ CATCH_TEST_CASE("example", "[example]")
         l->remove_component_to_ignore(snaplogger::g_cppthread_component);
     }
     CATCH_END_SECTION()
+
+    CATCH_START_SECTION("asynchronous: nested and context diagnostics are saved in the message")
+    {
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("test-buffer"));
+
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${message} ${diagnostic:nested} ${diagnostic:map=request_id}"));
+        buffer->set_format(f);
+
+        l->add_appender(buffer);
+        l->add_component_to_ignore(snaplogger::g_cppthread_component);
+
+        l->set_asynchronous(true);
+
+        {
+            snaplogger::nested_diagnostic outer("outer");
+            {
+                snaplogger::nested_diagnostic inner("inner");
+                snaplogger::scoped_context request("request_id", "r1");
+
+                SNAP_LOG_WARNING
+                    << "two levels"
+                    << SNAP_LOG_SEND;
+            }
+
+            SNAP_LOG_WARNING
+                << "one level"
+                << SNAP_LOG_SEND;
+        }
+
+        // the diagnostics are likely popped before the thread processes
+        // the messages, yet the messages still show them
+        //
+        l->set_asynchronous(false);
+
+        CATCH_REQUIRE(buffer->str() ==
+                  "two levels {outer/inner} <request_id=r1>\n"
+                  "one level {outer} \n");
+
+        l->remove_component_to_ignore(snaplogger::g_cppthread_component);
+        l->reset();
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("asynchronous: deferred formatting")
+    {
+        snaplogger::set_diagnostic(snaplogger::DIAG_KEY_PROGNAME, "async-unittest");
+
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("test-buffer"));
+
+        char const * cargv[] =
+        {
+            "/usr/bin/daemon",
+            nullptr
+        };
+        int const argc(sizeof(cargv) / sizeof(cargv[0]) - 1);
+        char ** argv = const_cast<char **>(cargv);
+
+        advgetopt::options_environment environment_options;
+        environment_options.f_project_name = "async-unittest";
+        environment_options.f_environment_flags = advgetopt::GETOPT_ENVIRONMENT_FLAG_SYSTEM_PARAMETERS;
+        advgetopt::getopt opts(environment_options);
+        opts.parse_program_name(argv);
+        opts.parse_arguments(argc, argv, advgetopt::option_source_t::SOURCE_COMMAND_LINE);
+
+        buffer->set_config(opts);
+
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${severity}: ${message}"));
+        buffer->set_format(f);
+
+        l->add_appender(buffer);
+        l->add_component_to_ignore(snaplogger::g_cppthread_component);
+
+        l->set_asynchronous(true);
+
+        // the message keeps a copy of the string so changing it right
+        // after the log statement has no effect on the output
+        //
+        {
+            std::string name("first");
+            SNAP_LOG_WARNING_FMT("{} message #{}", name.c_str(), 1)
+                << " with a tail"
+                << SNAP_LOG_SEND;
+            name[0] = 'F';
+
+            std::string user("second");
+            SNAP_LOG_WARNING_FMT("{} message #{:03}", user, 2) << SNAP_LOG_SEND;
+            user = "changed";
+        }
+
+        // a message which does not come from a SNAP_LOG_...() statement
+        // gets copied; the copy includes the rendered deferred part
+        //
+        {
+            snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_WARNING));
+            *msg << snaplogger::formatted("{} message #{}", "third", 3);
+            snaplogger::send_message(*msg);
+            *msg << " not sent";
+        }
+
+        l->set_asynchronous(false);
+
+        CATCH_REQUIRE(buffer->str() ==
+                  "warning: first message #1 with a tail\n"
+                  "warning: second message #002\n"
+                  "warning: third message #3\n");
+
+        l->remove_component_to_ignore(snaplogger::g_cppthread_component);
+        l->reset();
+    }
+    CATCH_END_SECTION()
 }
 
 
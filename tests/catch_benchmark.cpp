@@ -0,0 +1,473 @@
+// Copyright (c) 2006-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/snaplogger
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// self
+//
+#include    "catch_main.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/buffer_appender.h>
+#include    <snaplogger/format.h>
+#include    <snaplogger/guard.h>
+#include    <snaplogger/logger.h>
+#include    <snaplogger/message.h>
+
+
+// cppthread
+//
+#include    <cppthread/runner.h>
+#include    <cppthread/thread.h>
+
+
+// snapdev
+//
+#include    <snapdev/not_used.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <barrier>
+#include    <chrono>
+#include    <iomanip>
+#include    <numeric>
+#include    <sstream>
+
+
+
+// the benchmarks are hidden (the "[.]" tag); run them explicitly with:
+//
+//     unittest "[benchmark]"
+//
+
+
+
+namespace
+{
+
+
+
+// the message identifiers used to be allocated while holding the global
+// logger guard; this is that implementation, used as the baseline
+//
+std::uint32_t g_guarded_message_id = 0U;
+
+std::uint32_t get_next_guarded_id()
+{
+    snaplogger::guard g;
+
+    ++g_guarded_message_id;
+    if(g_guarded_message_id == 0)
+    {
+        g_guarded_message_id = 1;
+    }
+    return g_guarded_message_id;
+}
+
+
+// a runner allocating message identifiers as fast as possible; all the
+// runners wait on the same barrier so they start at the same time
+//
+class id_allocator
+    : public cppthread::runner
+{
+public:
+    typedef std::shared_ptr<id_allocator>           pointer_t;
+
+
+    id_allocator(std::size_t count, std::barrier<> & start, bool guarded)
+        : runner("id-allocator")
+        , f_count(count)
+        , f_start(start)
+        , f_guarded(guarded)
+    {
+    }
+
+
+    virtual void enter() override
+    {
+        // avoid the cppthread "entering" message
+    }
+
+
+    virtual void run() override
+    {
+        f_start.arrive_and_wait();
+
+        std::uint32_t last(0);
+        if(f_guarded)
+        {
+            for(std::size_t idx(0); idx < f_count; ++idx)
+            {
+                std::uint32_t const id(get_next_guarded_id());
+                if(id <= last)
+                {
+                    ++f_errors;
+                }
+                last = id;
+            }
+        }
+        else
+        {
+            for(std::size_t idx(0); idx < f_count; ++idx)
+            {
+                std::uint32_t const id(snaplogger::detail::get_next_message_id());
+                if(id <= last)
+                {
+                    ++f_errors;
+                }
+                last = id;
+            }
+        }
+    }
+
+
+    virtual void leave(cppthread::leave_status_t status) override
+    {
+        // avoid the cppthread "leaving" message
+        //
+        snapdev::NOT_USED(status);
+    }
+
+
+    // the CATCH_REQUIRE() macros are not thread safe so the errors
+    // get counted and verified once the thread is done
+    //
+    std::size_t get_errors() const
+    {
+        return f_errors;
+    }
+
+private:
+    std::size_t     f_count = 0;
+    std::barrier<> &
+                    f_start;
+    bool            f_guarded = false;
+    std::size_t     f_errors = 0;
+};
+
+
+// run thread_count allocators and return the number of seconds it took;
+// the clock starts once all the threads are ready
+//
+double allocate_ids(std::size_t thread_count, std::size_t count, bool guarded)
+{
+    std::barrier<> start(static_cast<std::ptrdiff_t>(thread_count + 1));
+
+    std::vector<id_allocator::pointer_t> runners;
+    std::vector<cppthread::thread::pointer_t> threads;
+    for(std::size_t idx(0); idx < thread_count; ++idx)
+    {
+        runners.push_back(std::make_shared<id_allocator>(count, start, guarded));
+        threads.push_back(std::make_shared<cppthread::thread>("id-allocator", runners.back().get()));
+    }
+
+    for(auto & t : threads)
+    {
+        CATCH_REQUIRE(t->start());
+    }
+
+    start.arrive_and_wait();
+    auto const start_time(std::chrono::steady_clock::now());
+    for(auto & t : threads)
+    {
+        t->stop();
+    }
+    auto const end_time(std::chrono::steady_clock::now());
+
+    // each thread must receive increasing identifiers
+    //
+    for(auto const & r : runners)
+    {
+        CATCH_REQUIRE(r->get_errors() == 0);
+    }
+
+    return std::chrono::duration<double>(end_time - start_time).count();
+}
+
+
+
+}
+
+
+
+CATCH_TEST_CASE("benchmark_message_id", "[benchmark][.]")
+{
+    CATCH_START_SECTION("benchmark: message identifiers from 1 to 64 threads")
+    {
+        std::size_t const count(100'000);
+
+        for(std::size_t thread_count(1); thread_count <= 64; thread_count *= 2)
+        {
+            std::uint32_t const total(static_cast<std::uint32_t>(thread_count * count));
+
+            // baseline: the counter protected by the logger guard
+            //
+            std::uint32_t const guarded_start_id(g_guarded_message_id);
+            double const guarded_seconds(allocate_ids(thread_count, count, true));
+            CATCH_REQUIRE(g_guarded_message_id - guarded_start_id == total);
+
+            // the atomic counter; all the identifiers must be unique
+            //
+            std::uint32_t const start_id(snaplogger::get_last_message_id());
+            double const atomic_seconds(allocate_ids(thread_count, count, false));
+            CATCH_REQUIRE(snaplogger::get_last_message_id() - start_id == total);
+
+            std::cout
+                << "--- "
+                << std::setw(2) << thread_count
+                << " thread(s), "
+                << total
+                << " identifiers: guard "
+                << std::fixed << std::setprecision(1)
+                << guarded_seconds * 1e9 / total
+                << "ns, atomic "
+                << atomic_seconds * 1e9 / total
+                << "ns\n";
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+CATCH_TEST_CASE("benchmark_message_construction", "[benchmark][.]")
+{
+    CATCH_START_SECTION("benchmark: construct and destroy messages")
+    {
+        std::size_t const count(100'000);
+
+        // baseline: the std::stringstream the message used to derive from
+        //
+        auto start_time(std::chrono::steady_clock::now());
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            std::stringstream ss;
+            ss << "message #" << idx;
+            snapdev::NOT_USED(ss);
+        }
+        double const stringstream_seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+        // a message allocated each time
+        //
+        start_time = std::chrono::steady_clock::now();
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            snaplogger::message::pointer_t msg(std::make_shared<snaplogger::message>(snaplogger::severity_t::SEVERITY_ERROR));
+            *msg << "message #" << idx;
+            CATCH_REQUIRE_FALSE(msg->view().empty());
+        }
+        double const message_seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+        // a message from the per thread pool
+        //
+        start_time = std::chrono::steady_clock::now();
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+            *msg << "message #" << idx;
+            CATCH_REQUIRE_FALSE(msg->view().empty());
+        }
+        double const pool_seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+        std::cout
+            << std::fixed << std::setprecision(1)
+            << "--- std::stringstream: " << stringstream_seconds * 1e9 / count << "ns\n"
+            << "--- message (new):     " << message_seconds * 1e9 / count << "ns\n"
+            << "--- message (pool):    " << pool_seconds * 1e9 / count << "ns\n";
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+CATCH_TEST_CASE("benchmark_format", "[benchmark][.]")
+{
+    CATCH_START_SECTION("benchmark: render a format with 12 variables")
+    {
+        std::size_t const count(100'000);
+
+        // the pieces of the format: 12 variables and the text in between
+        //
+        std::vector<std::string> const pieces =
+        {
+            "${date}", " ", "${time}", " ", "${hostname}", " ",
+            "${progname}", "[", "${pid}", "/", "${tid}", "]: ",
+            "${severity}", ": ", "${message}", " (in ", "${function}",
+            "() at ", "${basename}", ":", "${line}", ") ", "${fields}",
+        };
+        std::string const format_string(std::accumulate(pieces.begin(), pieces.end(), std::string()));
+
+        snaplogger::format::pointer_t const f(snaplogger::get_shared_format(format_string));
+        std::vector<snaplogger::format::pointer_t> piece_formats;
+        for(auto const & p : pieces)
+        {
+            piece_formats.push_back(std::make_shared<snaplogger::format>(p));
+        }
+
+        snaplogger::message msg(snaplogger::severity_t::SEVERITY_ERROR);
+        msg.set_filename("tests/catch_benchmark.cpp");
+        msg.set_function("benchmark_format");
+        msg.set_line(__LINE__);
+        msg.add_field("user", "alexis");
+        msg.add_field("request", 12345);
+        msg << "the format benchmark renders this message many times";
+
+        // baseline: one string per variable concatenated to a growing
+        // prefix as the format used to do with std::accumulate()
+        //
+        // this is an approximation of the old code: the variables of a
+        // format are not accessible so each piece is rendered by its own
+        // format which also reserves its result string and saves its size
+        // hint; the old code called variable::get_value() directly so the
+        // baseline is a little slower than the old implementation was
+        //
+        std::string expected;
+        auto start_time(std::chrono::steady_clock::now());
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            expected = std::accumulate(
+                      piece_formats.begin()
+                    , piece_formats.end()
+                    , std::string()
+                    , [&msg](std::string const & r, snaplogger::format::pointer_t const & piece)
+                    {
+                        return r + piece->process_message(msg);
+                    });
+        }
+        double const accumulate_seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+        // a new string reserved using the size of the previous render
+        //
+        std::string result;
+        start_time = std::chrono::steady_clock::now();
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            result = f->process_message(msg);
+        }
+        double const string_seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+        CATCH_REQUIRE(result == expected);
+
+        // one buffer reused for all the renders (what appenders do)
+        //
+        std::string buffer;
+        start_time = std::chrono::steady_clock::now();
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            buffer.clear();
+            f->process_message(msg, buffer);
+        }
+        double const buffer_seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+        CATCH_REQUIRE(buffer == expected);
+
+        std::cout
+            << std::fixed << std::setprecision(1)
+            << "--- accumulate (approx.): " << accumulate_seconds * 1e9 / count << "ns\n"
+            << "--- new string:           " << string_seconds * 1e9 / count << "ns\n"
+            << "--- reused buffer:        " << buffer_seconds * 1e9 / count << "ns\n";
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+
+CATCH_TEST_CASE("benchmark_asynchronous_format", "[benchmark][.]")
+{
+    CATCH_START_SECTION("benchmark: time spent by the caller of a log statement in asynchronous mode")
+    {
+        std::size_t const count(100'000);
+
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("test-buffer"));
+
+        char const * cargv[] =
+        {
+            "/usr/bin/daemon",
+            nullptr
+        };
+        int const argc(sizeof(cargv) / sizeof(cargv[0]) - 1);
+        char ** argv = const_cast<char **>(cargv);
+
+        advgetopt::options_environment environment_options;
+        environment_options.f_project_name = "benchmark";
+        environment_options.f_environment_flags = advgetopt::GETOPT_ENVIRONMENT_FLAG_SYSTEM_PARAMETERS;
+        advgetopt::getopt opts(environment_options);
+        opts.parse_program_name(argv);
+        opts.parse_arguments(argc, argv, advgetopt::option_source_t::SOURCE_COMMAND_LINE);
+
+        buffer->set_config(opts);
+
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${message}"));
+        buffer->set_format(f);
+
+        l->add_appender(buffer);
+        l->add_component_to_ignore(snaplogger::g_cppthread_component);
+        l->set_asynchronous(true);
+
+        std::string const user("alexis");
+        int const port(4040);
+
+        // the `<<` operators format the message in the calling thread
+        //
+        auto start_time(std::chrono::steady_clock::now());
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            SNAP_LOG_INFO
+                << "user "
+                << user
+                << " logged in on port "
+                << port
+                << " attempt #"
+                << idx
+                << SNAP_LOG_SEND;
+        }
+        double const stream_seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+        // the _FMT macros save their arguments in the message which gets
+        // formatted by the logger thread
+        //
+        start_time = std::chrono::steady_clock::now();
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            SNAP_LOG_INFO_FMT("user {} logged in on port {} attempt #{}", user, port, idx) << SNAP_LOG_SEND;
+        }
+        double const format_seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+        // wait for the logger thread to be done
+        //
+        l->set_asynchronous(false);
+
+        std::string const output(buffer->str());
+        CATCH_REQUIRE(static_cast<std::size_t>(std::count(output.begin(), output.end(), '\n')) == count * 2);
+
+        l->remove_component_to_ignore(snaplogger::g_cppthread_component);
+        l->reset();
+
+        std::cout
+            << std::fixed << std::setprecision(1)
+            << "--- operator <<:       " << stream_seconds * 1e9 / count << "ns\n"
+            << "--- _FMT (deferred):   " << format_seconds * 1e9 / count << "ns\n";
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,103 @@
+// Copyright (c) 2006-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/snaplogger
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// this file gets compiled with -DSNAPLOGGER_COMPILE_MIN_SEVERITY=140
+// (see tests/CMakeLists.txt) which is the SEVERITY_WARNING level
+
+// header being tested
+//
+#include    <snaplogger/message.h>
+
+
+// self
+//
+#include    "catch_main.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/buffer_appender.h>
+#include    <snaplogger/format.h>
+#include    <snaplogger/logger.h>
+#include    <snaplogger/severity.h>
+
+
+
+CATCH_TEST_CASE("compile_min_severity", "[message][severity]")
+{
+    CATCH_START_SECTION("compile_min_severity: statements below the floor are removed")
+    {
+        CATCH_REQUIRE(static_cast<int>(SNAPLOGGER_COMPILE_MIN_SEVERITY)
+                            == static_cast<int>(snaplogger::severity_t::SEVERITY_WARNING));
+
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("floor-buffer"));
+
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${severity}: ${message}"));
+        buffer->set_format(f);
+
+        l->add_appender(buffer);
+
+        // the run-time severity lets everything through
+        //
+        l->set_severity(snaplogger::severity_t::SEVERITY_ALL);
+        CATCH_REQUIRE(snaplogger::is_severity_enabled(snaplogger::severity_t::SEVERITY_DEBUG));
+        CATCH_REQUIRE(snaplogger::is_severity_enabled(snaplogger::severity_t::SEVERITY_INFORMATION));
+
+        int count(0);
+        auto const counter([&count]()
+            {
+                ++count;
+                return count;
+            });
+
+        // below the floor, the arguments are not evaluated and nothing
+        // gets logged
+        //
+        SNAP_LOG_DEBUG << "Debug counter " << counter() << " is not incremented" << SNAP_LOG_SEND;
+        SNAP_LOG_INFO << "Info counter " << counter() << " is not incremented" << SNAP_LOG_SEND;
+        SNAP_LOG_MINOR << "Minor counter " << counter() << " is not incremented" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(count == 0);
+        CATCH_REQUIRE(buffer->empty());
+
+        // at the floor and above, the messages still get logged
+        //
+        SNAP_LOG_WARNING << "Warning counter " << counter() << " is incremented" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(count == 1);
+        CATCH_REQUIRE(buffer->str() == "warning: Warning counter 1 is incremented\n");
+        buffer->clear();
+
+        SNAP_LOG_ERROR << "Error counter " << counter() << " is incremented" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(count == 2);
+        CATCH_REQUIRE(buffer->str() == "error: Error counter 2 is incremented\n");
+        buffer->clear();
+
+        // the run-time severity still applies above the floor
+        //
+        l->set_severity(snaplogger::severity_t::SEVERITY_ERROR);
+        SNAP_LOG_WARNING << "Warning counter " << counter() << " is not incremented" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(count == 2);
+        CATCH_REQUIRE(buffer->empty());
+
+        l->reset();
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -227,6 +227,103 @@ CATCH_TEST_CASE("component", "[component]")
         l->reset();
     }
     CATCH_END_SECTION()
+
+    CATCH_START_SECTION("component: components are saved in masks")
+    {
+        snaplogger::component::pointer_t mask_a(snaplogger::get_component("mask_a"));
+        snaplogger::component::pointer_t mask_b(snaplogger::get_component("mask_b"));
+        CATCH_REQUIRE(snaplogger::get_component_by_index(mask_a->get_index()) == mask_a);
+        CATCH_REQUIRE(snaplogger::get_component_by_index(mask_b->get_index()) == mask_b);
+        CATCH_REQUIRE(snaplogger::get_component_by_index(snaplogger::component::MAX_COMPONENTS) == nullptr);
+
+        snaplogger::component::set_t const set({ mask_a, mask_b });
+        snaplogger::component::mask_t const mask(snaplogger::to_component_mask(set));
+        CATCH_REQUIRE(mask.count() == 2);
+        CATCH_REQUIRE(mask.test(mask_a->get_index()));
+        CATCH_REQUIRE(mask.test(mask_b->get_index()));
+        CATCH_REQUIRE(snaplogger::to_component_set(mask) == set);
+
+        snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+        CATCH_REQUIRE(msg->get_component_mask().none());
+        msg->add_component(mask_a);
+        msg->add_component(snaplogger::g_normal_component);
+        CATCH_REQUIRE(msg->has_component(mask_a));
+        CATCH_REQUIRE_FALSE(msg->has_component(mask_b));
+        CATCH_REQUIRE(msg->get_component_mask().count() == 2);
+        CATCH_REQUIRE(msg->get_components() == snaplogger::component::set_t({ mask_a, snaplogger::g_normal_component }));
+
+        // "secure" and "normal" are mutually exclusive
+        //
+        CATCH_REQUIRE(snaplogger::g_secure_component->is_mutually_exclusive(snaplogger::g_normal_component));
+        CATCH_REQUIRE(snaplogger::g_secure_component->is_mutually_exclusive(msg->get_component_mask()));
+        CATCH_REQUIRE_FALSE(msg->can_add_component(snaplogger::g_secure_component));
+        CATCH_REQUIRE_THROWS_AS(msg->add_component(snaplogger::g_secure_component), snaplogger::conflict_error);
+
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("mask-buffer"));
+        CATCH_REQUIRE(buffer->get_component_mask().none());
+        CATCH_REQUIRE(buffer->get_components() == nullptr);
+        buffer->add_component(mask_b);
+        CATCH_REQUIRE(buffer->get_component_mask().test(mask_b->get_index()));
+        CATCH_REQUIRE(*buffer->get_components() == snaplogger::component::set_t({ mask_b }));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("component: messages are routed by severity and components")
+    {
+        snaplogger::component::pointer_t routing_a(snaplogger::get_component("routing_a"));
+        snaplogger::component::pointer_t routing_b(snaplogger::get_component("routing_b"));
+        CATCH_REQUIRE(routing_a->get_index() != routing_b->get_index());
+        CATCH_REQUIRE(routing_a->get_index() != snaplogger::g_normal_component->get_index());
+
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${message}"));
+
+        snaplogger::buffer_appender::pointer_t a(std::make_shared<snaplogger::buffer_appender>("routing-a"));
+        a->set_format(f);
+        a->add_component(routing_a);
+        a->set_severity(snaplogger::severity_t::SEVERITY_ERROR);
+        l->add_appender(a);
+
+        snaplogger::buffer_appender::pointer_t b(std::make_shared<snaplogger::buffer_appender>("routing-b"));
+        b->set_format(f);
+        b->add_component(routing_b);
+        b->add_component(snaplogger::g_normal_component);
+        b->set_severity(snaplogger::severity_t::SEVERITY_DEBUG);
+        l->add_appender(b);
+
+        // without components, only messages without components are accepted
+        //
+        snaplogger::buffer_appender::pointer_t c(std::make_shared<snaplogger::buffer_appender>("routing-c"));
+        c->set_format(f);
+        c->set_severity(snaplogger::severity_t::SEVERITY_INFORMATION);
+        l->add_appender(c);
+
+        SNAP_LOG_ERROR << snaplogger::section(routing_a) << "error for a" << SNAP_LOG_SEND;
+        SNAP_LOG_DEBUG << snaplogger::section(routing_a) << "debug for a" << SNAP_LOG_SEND;
+        SNAP_LOG_ERROR << "error without components" << SNAP_LOG_SEND;
+        SNAP_LOG_INFORMATION << snaplogger::section(routing_a) << snaplogger::section(routing_b) << "info for a and b" << SNAP_LOG_SEND;
+
+        CATCH_REQUIRE(a->str() == "error for a\n");
+        CATCH_REQUIRE(b->str() == "error without components\ninfo for a and b\n");
+        CATCH_REQUIRE(c->str() == "error without components\n");
+
+        // the severity change is taken in account immediately
+        //
+        a->set_severity(snaplogger::severity_t::SEVERITY_DEBUG);
+        SNAP_LOG_DEBUG << snaplogger::section(routing_a) << "debug for a" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(a->str() == "error for a\ndebug for a\n");
+
+        // the logger can ignore a component altogether
+        //
+        l->add_component_to_ignore(routing_b);
+        SNAP_LOG_ERROR << snaplogger::section(routing_a) << snaplogger::section(routing_b) << "ignored" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(a->str() == "error for a\ndebug for a\n");
+        CATCH_REQUIRE(b->str() == "error without components\ninfo for a and b\n");
+        l->remove_component_to_ignore(routing_b);
+
+        l->reset();
+    }
+    CATCH_END_SECTION()
 }
 
 
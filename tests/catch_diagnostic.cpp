@@ -34,6 +34,11 @@
 #include    <snaplogger/version.h>
 
 
+// C++
+//
+#include    <thread>
+
+
 // C
 //
 #include    <unistd.h>
@@ -145,6 +150,147 @@ CATCH_TEST_CASE("diagnostic", "[message][diagnostic]")
         l->reset();
     }
     CATCH_END_SECTION()
+
+    CATCH_START_SECTION("diagnostic: nested diagnostics are per thread")
+    {
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("test-buffer"));
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${message} ${diagnostic:nested}"));
+        buffer->set_format(f);
+        l->add_appender(buffer);
+
+        snaplogger::nested_diagnostic main_level("main");
+
+        std::thread other([]()
+            {
+                CATCH_REQUIRE(snaplogger::get_nested_diagnostics().empty());
+
+                snaplogger::nested_diagnostic other_level("other");
+                CATCH_REQUIRE(snaplogger::get_nested_diagnostics() == snaplogger::string_vector_t({ "other" }));
+
+                SNAP_LOG_WARNING
+                    << "from thread"
+                    << SNAP_LOG_SEND;
+            });
+        other.join();
+
+        CATCH_REQUIRE(snaplogger::get_nested_diagnostics() == snaplogger::string_vector_t({ "main" }));
+
+        SNAP_LOG_WARNING
+            << "from main"
+            << SNAP_LOG_SEND;
+
+        CATCH_REQUIRE(buffer->str() ==
+                "from thread {other}\n"
+                "from main {main}\n");
+
+        l->reset();
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("diagnostic: global diagnostics snapshots")
+    {
+        snaplogger::map_diagnostics_pointer_t before(snaplogger::get_map_diagnostics_snapshot());
+        CATCH_REQUIRE(before != nullptr);
+        CATCH_REQUIRE_FALSE(before->contains("snapshot_diag"));
+
+        snaplogger::set_diagnostic("snapshot_diag", "v1");
+
+        // the old snapshot is not modified
+        //
+        CATCH_REQUIRE_FALSE(before->contains("snapshot_diag"));
+
+        snaplogger::map_diagnostics_pointer_t after(snaplogger::get_map_diagnostics_snapshot());
+        CATCH_REQUIRE(after != before);
+        CATCH_REQUIRE(after->at("snapshot_diag") == "v1");
+        CATCH_REQUIRE(snaplogger::get_diagnostic("snapshot_diag") == "v1");
+
+        // setting the same value does not create a new snapshot
+        //
+        snaplogger::set_diagnostic("snapshot_diag", "v1");
+        CATCH_REQUIRE(snaplogger::get_map_diagnostics_snapshot() == after);
+
+        snaplogger::message msg(snaplogger::severity_t::SEVERITY_ERROR);
+        CATCH_REQUIRE(*snaplogger::find_diagnostic(msg, *after, "snapshot_diag") == "v1");
+        CATCH_REQUIRE(snaplogger::find_diagnostic(msg, *after, "undefined_diag") == nullptr);
+        {
+            snaplogger::scoped_context ctx("snapshot_diag", "context");
+            CATCH_REQUIRE(*snaplogger::find_diagnostic(msg, *after, "snapshot_diag") == "context");
+        }
+
+        snaplogger::unset_diagnostic("snapshot_diag");
+        CATCH_REQUIRE(after->at("snapshot_diag") == "v1");
+        CATCH_REQUIRE_FALSE(snaplogger::get_map_diagnostics_snapshot()->contains("snapshot_diag"));
+        CATCH_REQUIRE(snaplogger::get_diagnostic("snapshot_diag").empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("diagnostic: scoped contexts")
+    {
+        snaplogger::set_diagnostic("ctx_global", "global");
+        snaplogger::set_diagnostic("ctx_shadow", "global-shadow");
+
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("test-buffer"));
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>(
+                    "${message}"
+                    " ${diagnostic:map=ctx_global}"
+                    "${diagnostic:map=ctx_shadow}"
+                    "${diagnostic:map=request_id}"));
+        buffer->set_format(f);
+        l->add_appender(buffer);
+
+        CATCH_REQUIRE(snaplogger::get_thread_context_diagnostics().empty());
+
+        {
+            snaplogger::scoped_context request("request_id", 1234);
+            snaplogger::scoped_context shadow("ctx_shadow", "context-shadow");
+            CATCH_REQUIRE(snaplogger::get_thread_context_diagnostics().size() == 2);
+
+            SNAP_LOG_WARNING
+                << "in context"
+                << SNAP_LOG_SEND;
+
+            std::thread other([]()
+                {
+                    // the context of the main thread is not visible here
+                    //
+                    CATCH_REQUIRE(snaplogger::get_thread_context_diagnostics().empty());
+
+                    snaplogger::scoped_context request("request_id", "other");
+
+                    SNAP_LOG_WARNING
+                        << "in thread"
+                        << SNAP_LOG_SEND;
+                });
+            other.join();
+
+            {
+                snaplogger::scoped_context inner("request_id", "inner");
+
+                SNAP_LOG_WARNING
+                    << "in inner context"
+                    << SNAP_LOG_SEND;
+            }
+        }
+
+        CATCH_REQUIRE(snaplogger::get_thread_context_diagnostics().empty());
+
+        SNAP_LOG_WARNING
+            << "out of context"
+            << SNAP_LOG_SEND;
+
+        CATCH_REQUIRE(buffer->str() ==
+                "in context <ctx_global=global><ctx_shadow=context-shadow><request_id=1234>\n"
+                "in thread <ctx_global=global><ctx_shadow=global-shadow><request_id=other>\n"
+                "in inner context <ctx_global=global><ctx_shadow=context-shadow><request_id=inner>\n"
+                "out of context <ctx_global=global><ctx_shadow=global-shadow>\n");
+
+        snaplogger::unset_diagnostic("ctx_global");
+        snaplogger::unset_diagnostic("ctx_shadow");
+        l->reset();
+    }
+    CATCH_END_SECTION()
 }
 
 
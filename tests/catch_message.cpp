@@ -29,6 +29,7 @@
 // cppthread
 //
 #include    <cppthread/log.h>
+#include    <cppthread/thread.h>
 
 
 // as2js
@@ -39,6 +40,7 @@
 // snaplogger
 //
 #include    <snaplogger/buffer_appender.h>
+#include    <snaplogger/clock.h>
 #include    <snaplogger/exception.h>
 #include    <snaplogger/format.h>
 #include    <snaplogger/logger.h>
@@ -57,9 +59,21 @@
 #include    <advgetopt/exception.h>
 
 
+// C++
+//
+#include    <algorithm>
+#include    <chrono>
+#include    <limits>
+#include    <set>
+#include    <thread>
+
+
 // C
 //
+#include    <limits.h>
 #include    <math.h>
+#include    <pwd.h>
+#include    <sys/wait.h>
 #include    <unistd.h>
 
 
@@ -169,7 +183,39 @@ CATCH_TEST_CASE("message_capture", "[message]")
         SNAP_LOG_DEBUG << "Debug Message " << M_PI << " which does not make it at all...\n" << SNAP_LOG_SEND;
         CATCH_REQUIRE(buffer->empty());
 
+        // severity too low, the arguments do not even get evaluated
+        //
+        int count(0);
+        auto const counter([&count]()
+            {
+                ++count;
+                return count;
+            });
+        CATCH_REQUIRE_FALSE(snaplogger::is_severity_enabled(snaplogger::severity_t::SEVERITY_DEBUG));
+        SNAP_LOG_DEBUG << "Debug counter " << counter() << " is not incremented" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(count == 0);
+        CATCH_REQUIRE(buffer->empty());
+
+        CATCH_REQUIRE(snaplogger::is_severity_enabled(snaplogger::severity_t::SEVERITY_ERROR));
+        SNAP_LOG_ERROR << "Error counter " << counter() << " is incremented" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(count == 1);
+        CATCH_REQUIRE(buffer->str() == "error: Error counter 1 is incremented\n");
+        buffer->clear();
+
+        // lower the severity, now debug messages make it too
+        //
+        l->set_severity(snaplogger::severity_t::SEVERITY_DEBUG);
+        CATCH_REQUIRE(snaplogger::is_severity_enabled(snaplogger::severity_t::SEVERITY_DEBUG));
+        SNAP_LOG_DEBUG << "Debug counter " << counter() << " is incremented" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(count == 2);
+        CATCH_REQUIRE(buffer->str() == "debug: Debug counter 2 is incremented\n");
+        buffer->clear();
+
         l->reset();
+
+        // without appenders, all the messages are accepted
+        //
+        CATCH_REQUIRE(snaplogger::is_severity_enabled(snaplogger::severity_t::SEVERITY_ALL));
     }
     CATCH_END_SECTION()
 
@@ -336,6 +382,171 @@ CATCH_TEST_CASE("message_copy", "[message]")
 }
 
 
+CATCH_TEST_CASE("message_fields", "[message][field]")
+{
+    CATCH_START_SECTION("message: typed fields")
+    {
+        snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+        *msg << SNAP_LOG_FIELD("count", 42)
+             << SNAP_LOG_FIELD("ratio", 0.25)
+             << SNAP_LOG_FIELD("valid", true)
+             << SNAP_LOG_FIELD("name", "snaplogger");
+
+        // the values keep their type until rendered
+        //
+        snaplogger::field_list const & fields(msg->get_field_list());
+        CATCH_REQUIRE(fields.find("count")->get_type() == snaplogger::field_type_t::FIELD_TYPE_INTEGER);
+        CATCH_REQUIRE(fields.find("ratio")->get_type() == snaplogger::field_type_t::FIELD_TYPE_FLOATING_POINT);
+        CATCH_REQUIRE(fields.find("valid")->get_type() == snaplogger::field_type_t::FIELD_TYPE_BOOLEAN);
+        CATCH_REQUIRE(fields.find("name")->get_type() == snaplogger::field_type_t::FIELD_TYPE_STRING);
+        CATCH_REQUIRE(fields.find("id") == nullptr);  // system field
+        CATCH_REQUIRE(fields.find("unknown") == nullptr);
+
+        CATCH_REQUIRE(msg->get_field("count") == "42");
+        CATCH_REQUIRE(msg->get_field("ratio") == "0.25");
+        CATCH_REQUIRE(msg->get_field("valid") == "true");
+        CATCH_REQUIRE(msg->get_field("name") == "snaplogger");
+        CATCH_REQUIRE(msg->get_field("unknown").empty());
+
+        // replacing a field can change its type
+        //
+        msg->add_field("count", "many");
+        CATCH_REQUIRE(fields.find("count")->get_type() == snaplogger::field_type_t::FIELD_TYPE_STRING);
+
+        // the map is sorted and includes the message identifier
+        //
+        snaplogger::field_map_t const map(msg->get_fields());
+        CATCH_REQUIRE(map.size() == 5);
+        auto it(map.begin());
+        CATCH_REQUIRE(it->first == "count");
+        CATCH_REQUIRE(it->second == "many");
+        ++it;
+        CATCH_REQUIRE(it->first == "id");
+        CATCH_REQUIRE(it->second == std::to_string(msg->get_id()));
+        ++it;
+        CATCH_REQUIRE(it->first == "name");
+        ++it;
+        CATCH_REQUIRE(it->first == "ratio");
+        ++it;
+        CATCH_REQUIRE(it->first == "valid");
+
+        // more fields than the inline array can hold
+        //
+        for(std::size_t idx(0); idx < snaplogger::field_list::INLINE_FIELDS * 2; ++idx)
+        {
+            msg->add_field("extra" + std::to_string(idx), idx);
+        }
+        for(std::size_t idx(0); idx < snaplogger::field_list::INLINE_FIELDS * 2; ++idx)
+        {
+            CATCH_REQUIRE(msg->get_field("extra" + std::to_string(idx)) == std::to_string(idx));
+        }
+        CATCH_REQUIRE(fields.size() == 4 + snaplogger::field_list::INLINE_FIELDS * 2);
+
+        // names added at run time are not interned, an interned name
+        // still finds them
+        //
+        std::string const * extra(snaplogger::intern_field_name("extra3"));
+        CATCH_REQUIRE(msg->get_field(extra) == "3");
+
+        snaplogger::field_list list;
+        list.set("user", "alexis");
+        list.set(snaplogger::intern_field_name("user"), "doug");
+        CATCH_REQUIRE(list.size() == 1);
+        CATCH_REQUIRE(list.get("user") == "doug");
+        CATCH_REQUIRE(list.find(snaplogger::intern_field_name("user")) != nullptr);
+        CATCH_REQUIRE(list.get_name(0) == "user");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("message: integer and character fields")
+    {
+        snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+        *msg << SNAP_LOG_FIELD("largest", std::numeric_limits<std::uint64_t>::max())
+             << SNAP_LOG_FIELD("size", static_cast<std::uint64_t>(1'024))
+             << SNAP_LOG_FIELD("smallest", std::numeric_limits<std::int64_t>::min())
+             << SNAP_LOG_FIELD("byte", static_cast<std::uint8_t>(200))
+             << SNAP_LOG_FIELD("letter", 'x');
+
+        snaplogger::field_list const & fields(msg->get_field_list());
+
+        // unsigned values larger than INT64_MAX do not become negative
+        //
+        CATCH_REQUIRE(fields.find("largest")->get_type() == snaplogger::field_type_t::FIELD_TYPE_UNSIGNED_INTEGER);
+        CATCH_REQUIRE(msg->get_field("largest") == "18446744073709551615");
+
+        // other unsigned values are saved as signed integers
+        //
+        CATCH_REQUIRE(fields.find("size")->get_type() == snaplogger::field_type_t::FIELD_TYPE_INTEGER);
+        CATCH_REQUIRE(msg->get_field("size") == "1024");
+
+        CATCH_REQUIRE(fields.find("smallest")->get_type() == snaplogger::field_type_t::FIELD_TYPE_INTEGER);
+        CATCH_REQUIRE(msg->get_field("smallest") == "-9223372036854775808");
+
+        // a std::uint8_t is a number, a char is a character
+        //
+        CATCH_REQUIRE(fields.find("byte")->get_type() == snaplogger::field_type_t::FIELD_TYPE_INTEGER);
+        CATCH_REQUIRE(msg->get_field("byte") == "200");
+
+        CATCH_REQUIRE(fields.find("letter")->get_type() == snaplogger::field_type_t::FIELD_TYPE_STRING);
+        CATCH_REQUIRE(msg->get_field("letter") == "x");
+
+        // other character types cannot be used as is
+        //
+        static_assert(!std::is_constructible_v<snaplogger::field_value, char8_t>);
+        static_assert(!std::is_constructible_v<snaplogger::field_value, char16_t>);
+        static_assert(!std::is_constructible_v<snaplogger::field_value, char32_t>);
+        static_assert(!std::is_constructible_v<snaplogger::field_value, wchar_t>);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("message: default fields are shared")
+    {
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        l->add_default_field("cluster", "east");
+        l->add_default_field("shard", "7");
+
+        snaplogger::message::pointer_t msg1(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+        snaplogger::message::pointer_t msg2(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+
+        // both messages reference the same snapshot
+        //
+        CATCH_REQUIRE(msg1->get_default_field_list() != nullptr);
+        CATCH_REQUIRE(msg1->get_default_field_list() == msg2->get_default_field_list());
+        CATCH_REQUIRE(msg1->get_field_list().find("cluster") == nullptr);
+        CATCH_REQUIRE(msg1->get_field("cluster") == "east");
+        CATCH_REQUIRE(msg1->get_field("shard") == "7");
+
+        // a message can override a default field
+        //
+        msg2->add_field("cluster", "west");
+        CATCH_REQUIRE(msg1->get_field("cluster") == "east");
+        CATCH_REQUIRE(msg2->get_field("cluster") == "west");
+        CATCH_REQUIRE(msg2->get_fields().at("cluster") == "west");
+        CATCH_REQUIRE(msg2->get_fields().at("shard") == "7");
+
+        // changing the defaults does not affect existing messages
+        //
+        l->add_default_field("shard", "8");
+        CATCH_REQUIRE(l->get_default_field("shard") == "8");
+        CATCH_REQUIRE(msg1->get_field("shard") == "7");
+
+        snaplogger::message::pointer_t msg3(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+        CATCH_REQUIRE(msg3->get_default_field_list() != msg1->get_default_field_list());
+        CATCH_REQUIRE(msg3->get_field("shard") == "8");
+
+        l->remove_default_field("cluster");
+        l->remove_default_field("shard");
+        CATCH_REQUIRE(l->get_default_fields().empty());
+        CATCH_REQUIRE(msg3->get_field("cluster") == "east");
+
+        snaplogger::message::pointer_t msg4(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+        CATCH_REQUIRE(msg4->get_field("cluster").empty());
+    }
+    CATCH_END_SECTION()
+}
+
+
+
 CATCH_TEST_CASE("message_severity", "[message][severity]")
 {
     CATCH_START_SECTION("message: Appender vs Message severity")
@@ -625,6 +836,253 @@ CATCH_TEST_CASE("message_format", "[message][format]")
     }
     CATCH_END_SECTION()
 
+    CATCH_START_SECTION("message: all the messages of a thread share the same environment")
+    {
+        snaplogger::environment::pointer_t env(snaplogger::create_environment());
+        CATCH_REQUIRE(env != nullptr);
+        CATCH_REQUIRE(env->get_tid() == cppthread::gettid());
+        CATCH_REQUIRE(snaplogger::create_environment() == env);
+
+        snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+        CATCH_REQUIRE(msg->get_environment() == env);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("message: the environment of a thread is released when it exits")
+    {
+        snaplogger::environment::pointer_t const env(snaplogger::create_environment());
+
+        // create more threads than the environment map limit; once a
+        // thread is joined, nothing references its environment anymore,
+        // including the map, so the weak pointer expires
+        //
+        std::vector<std::weak_ptr<snaplogger::environment>> environments;
+        for(int i(0); i < 1'100; ++i)
+        {
+            std::weak_ptr<snaplogger::environment> weak;
+            bool valid(false);
+            std::thread other([&weak, &valid, &env]()
+                {
+                    snaplogger::environment::pointer_t const thread_env(snaplogger::create_environment());
+                    weak = thread_env;
+                    valid = thread_env != env
+                         && thread_env->get_tid() == cppthread::gettid()
+                         && snaplogger::create_environment() == thread_env;
+
+                    // the message pool of the thread also references
+                    // the environment until the thread exits
+                    //
+                    snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+                    valid = valid && msg->get_environment() == thread_env;
+                });
+            other.join();
+            CATCH_REQUIRE(valid);
+            environments.push_back(weak);
+        }
+        for(auto const & weak : environments)
+        {
+            CATCH_REQUIRE(weak.expired());
+        }
+
+        // the environment of this thread is not affected
+        //
+        CATCH_REQUIRE(snaplogger::create_environment() == env);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("message: a child process gets a new environment")
+    {
+        snaplogger::environment::pointer_t const env(snaplogger::create_environment());
+
+        pid_t const child(fork());
+        CATCH_REQUIRE(child != -1);
+        if(child == 0)
+        {
+            // do not use CATCH_REQUIRE() in the child, return the result
+            // in the exit code instead
+            //
+            snaplogger::environment::pointer_t const child_env(snaplogger::create_environment());
+            bool const valid(child_env != env
+                          && child_env->get_pid() == getpid()
+                          && child_env->get_tid() == cppthread::gettid()
+                          && snaplogger::create_environment() == child_env);
+            _exit(valid ? 0 : 1);
+        }
+
+        int status(0);
+        CATCH_REQUIRE(waitpid(child, &status, 0) == child);
+        CATCH_REQUIRE(WIFEXITED(status));
+        CATCH_REQUIRE(WEXITSTATUS(status) == 0);
+
+        CATCH_REQUIRE(snaplogger::create_environment() == env);
+        CATCH_REQUIRE(env->get_pid() == getpid());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("message: messages get recycled")
+    {
+        std::set<snaplogger::message *> addresses;
+        std::uint32_t id(0);
+        for(int i(0); i < 200; ++i)
+        {
+            snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+            addresses.insert(msg.get());
+
+            // a recycled message must look brand new
+            //
+            CATCH_REQUIRE(msg->str().empty());
+            CATCH_REQUIRE(msg->get_components().empty());
+            CATCH_REQUIRE(msg->get_severity() == snaplogger::severity_t::SEVERITY_ERROR);
+            CATCH_REQUIRE(std::stoul(msg->get_field("id")) > id);
+            id = std::stoul(msg->get_field("id"));
+            CATCH_REQUIRE(msg->get_field("extra").empty());
+
+            *msg << "Message #" << i << snaplogger::secure << snaplogger::field("extra", "value");
+        }
+        CATCH_REQUIRE(addresses.size() <= 64);
+
+        // a copy is a different object with the same content
+        //
+        snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+        *msg << "Copy me" << snaplogger::field("extra", "value");
+        snaplogger::message::pointer_t copy(snaplogger::copy_message(*msg));
+        CATCH_REQUIRE(copy != msg);
+        CATCH_REQUIRE(copy->str() == "Copy me");
+        CATCH_REQUIRE(copy->get_field("extra") == "value");
+        CATCH_REQUIRE(copy->get_field("id") == msg->get_field("id"));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("message: each log statement has one call site")
+    {
+        std::size_t const count(snaplogger::get_call_sites().size());
+
+        snaplogger::call_site const * site(nullptr);
+        std::uint_least32_t const line(__LINE__ + 5);
+        for(int i(0); i < 3; ++i)
+        {
+            snaplogger::message::pointer_t msg(snaplogger::create_message(
+                      snaplogger::severity_t::SEVERITY_ERROR
+                    , SNAP_LOG_CALL_SITE(snaplogger::severity_t::SEVERITY_ERROR)));
+            if(site == nullptr)
+            {
+                site = msg->get_call_site();
+                CATCH_REQUIRE(site != nullptr);
+            }
+            CATCH_REQUIRE(msg->get_call_site() == site);
+            CATCH_REQUIRE(msg->get_filename() == __FILE__);
+            CATCH_REQUIRE_FALSE(msg->get_function().empty());
+
+            // the names are not copied, they are the call site strings
+            //
+            CATCH_REQUIRE(msg->get_filename().data() == site->get_filename());
+            CATCH_REQUIRE(msg->get_function().data() == site->get_function());
+            CATCH_REQUIRE(msg->get_line() == line);
+
+            // changing the filename detaches the message from its call site
+            //
+            msg->set_filename("changed.cpp");
+            CATCH_REQUIRE(msg->get_call_site() == nullptr);
+            CATCH_REQUIRE(msg->get_filename() == "changed.cpp");
+            CATCH_REQUIRE(msg->get_function() == site->get_function());
+        }
+
+        snaplogger::call_site::vector_t const sites(snaplogger::get_call_sites());
+        CATCH_REQUIRE(sites.size() == count + 1);
+        CATCH_REQUIRE(std::find(sites.begin(), sites.end(), site) != sites.end());
+        CATCH_REQUIRE(std::string(site->get_filename()) == __FILE__);
+        CATCH_REQUIRE(site->get_line() == line);
+        CATCH_REQUIRE(site->get_severity() == snaplogger::severity_t::SEVERITY_ERROR);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("message: clock sources")
+    {
+        CATCH_REQUIRE(snaplogger::get_clock_source() == snaplogger::clock_source_t::CLOCK_SOURCE_COARSE);
+
+        CATCH_REQUIRE(snaplogger::set_clock_source(snaplogger::clock_source_t::CLOCK_SOURCE_REALTIME)
+                                    == snaplogger::clock_source_t::CLOCK_SOURCE_REALTIME);
+
+        // the TSC falls back to realtime when it is not invariant
+        //
+        snaplogger::clock_source_t const expected(snaplogger::is_invariant_tsc_available()
+                        ? snaplogger::clock_source_t::CLOCK_SOURCE_TSC
+                        : snaplogger::clock_source_t::CLOCK_SOURCE_REALTIME);
+        CATCH_REQUIRE(snaplogger::set_clock_source(snaplogger::clock_source_t::CLOCK_SOURCE_TSC) == expected);
+        CATCH_REQUIRE(snaplogger::get_clock_source() == expected);
+
+        timespec previous{ 0, 0 };
+        for(int i(0); i < 10; ++i)
+        {
+            timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            snaplogger::message::pointer_t msg(snaplogger::create_message(snaplogger::severity_t::SEVERITY_ERROR));
+            timespec const & timestamp(msg->get_timestamp());
+            CATCH_REQUIRE(std::abs(timestamp.tv_sec - now.tv_sec) <= 1);
+            CATCH_REQUIRE((timestamp.tv_sec > previous.tv_sec
+                        || (timestamp.tv_sec == previous.tv_sec && timestamp.tv_nsec >= previous.tv_nsec)));
+            previous = timestamp;
+        }
+
+        if(expected == snaplogger::clock_source_t::CLOCK_SOURCE_TSC)
+        {
+            // the TSC gets anchored again about once a second, the
+            // timestamps must not go back when that happens
+            //
+            auto const end(std::chrono::steady_clock::now() + std::chrono::milliseconds(1'500));
+            while(std::chrono::steady_clock::now() < end)
+            {
+                timespec const timestamp(snaplogger::detail::tsc_to_timespec(snaplogger::detail::read_tsc()));
+                CATCH_REQUIRE((timestamp.tv_sec > previous.tv_sec
+                            || (timestamp.tv_sec == previous.tv_sec && timestamp.tv_nsec >= previous.tv_nsec)));
+                previous = timestamp;
+            }
+
+            // a TSC value converted after a newer one does not give an
+            // earlier timestamp
+            //
+            std::uint64_t const older(snaplogger::detail::read_tsc());
+            timespec const newer(snaplogger::detail::tsc_to_timespec(snaplogger::detail::read_tsc()));
+            timespec const late(snaplogger::detail::tsc_to_timespec(older));
+            CATCH_REQUIRE((late.tv_sec > newer.tv_sec
+                        || (late.tv_sec == newer.tv_sec && late.tv_nsec >= newer.tv_nsec)));
+        }
+
+        snaplogger::clock_source_t source(snaplogger::clock_source_t::CLOCK_SOURCE_COARSE);
+        CATCH_REQUIRE(snaplogger::clock_source_from_name("realtime", source));
+        CATCH_REQUIRE(source == snaplogger::clock_source_t::CLOCK_SOURCE_REALTIME);
+        CATCH_REQUIRE_FALSE(snaplogger::clock_source_from_name("sundial", source));
+        CATCH_REQUIRE(source == snaplogger::clock_source_t::CLOCK_SOURCE_REALTIME);
+
+        snaplogger::set_clock_source(snaplogger::clock_source_t::CLOCK_SOURCE_COARSE);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("message: the process identity is cached until refreshed")
+    {
+        snaplogger::environment::pointer_t env(snaplogger::create_environment());
+
+        char host[HOST_NAME_MAX + 2];
+        host[HOST_NAME_MAX + 1] = '\0';
+        CATCH_REQUIRE(gethostname(host, HOST_NAME_MAX + 1) == 0);
+        CATCH_REQUIRE(env->get_hostname() == host);
+
+        passwd const * pw(getpwuid(getuid()));
+        CATCH_REQUIRE(pw != nullptr);
+        CATCH_REQUIRE(env->get_username() == pw->pw_name);
+
+        std::string const boot_id(env->get_boot_id());
+        CATCH_REQUIRE(boot_id == cppthread::get_boot_id());
+
+        // after a refresh, the values get resolved again
+        //
+        snaplogger::refresh_identity();
+        CATCH_REQUIRE(env->get_hostname() == host);
+        CATCH_REQUIRE(env->get_username() == pw->pw_name);
+        CATCH_REQUIRE(env->get_boot_id() == boot_id);
+    }
+    CATCH_END_SECTION()
+
     CATCH_START_SECTION("message: Verify year")
     {
         snaplogger::set_diagnostic(snaplogger::DIAG_KEY_PROGNAME, "get-environment");
@@ -1469,6 +1927,65 @@ CATCH_TEST_CASE("message_exception", "[message][exception]")
     CATCH_END_SECTION()
 }
 
+CATCH_TEST_CASE("message_format_string", "[message][format]")
+{
+    CATCH_START_SECTION("message: SNAP_LOG_..._FMT() macros")
+    {
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("test-buffer"));
+
+        char const * cargv[] =
+        {
+            "/usr/bin/daemon",
+            nullptr
+        };
+        int const argc(sizeof(cargv) / sizeof(cargv[0]) - 1);
+        char ** argv = const_cast<char **>(cargv);
+
+        advgetopt::options_environment environment_options;
+        environment_options.f_project_name = "test-logger";
+        environment_options.f_environment_flags = advgetopt::GETOPT_ENVIRONMENT_FLAG_SYSTEM_PARAMETERS;
+        advgetopt::getopt opts(environment_options);
+        opts.parse_program_name(argv);
+        opts.parse_arguments(argc, argv, advgetopt::option_source_t::SOURCE_COMMAND_LINE);
+
+        buffer->set_config(opts);
+
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${severity}: ${message} [${field:name=user}]"));
+        buffer->set_format(f);
+
+        l->add_appender(buffer);
+
+        std::string const user("alexis");
+        int const port(4040);
+        SNAP_LOG_ERROR_FMT("user {} logged in on port {} after {:.2f}s", user, port, 1.5)
+                << SNAP_LOG_FIELD("user", user)
+                << SNAP_LOG_SEND;
+        CATCH_REQUIRE(buffer->str() == "error: user alexis logged in on port 4040 after 1.50s [alexis]\n");
+        buffer->clear();
+
+        // the secure component gets added as usual
+        //
+        SNAP_LOG_ERROR_FMT("{:#x}", 255) << SNAP_LOG_SEND_SECURELY;
+        CATCH_REQUIRE(buffer->empty());
+
+        // disabled severities do not evaluate the arguments
+        //
+        int count(0);
+        auto const counter([&count]()
+            {
+                ++count;
+                return count;
+            });
+        SNAP_LOG_DEBUG_FMT("counter {}", counter()) << SNAP_LOG_SEND;
+        CATCH_REQUIRE(count == 0);
+        CATCH_REQUIRE(buffer->empty());
+
+        l->reset();
+    }
+    CATCH_END_SECTION()
+}
+
 
 
 // vim: ts=4 sw=4 et
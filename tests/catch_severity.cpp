@@ -260,6 +260,51 @@ CATCH_TEST_CASE("severity", "[severity]")
     }
     CATCH_END_SECTION()
 
+    CATCH_START_SECTION("severity: severity table")
+    {
+        snaplogger::severity_table_pointer_t table(snaplogger::get_severity_table());
+        CATCH_REQUIRE(table != nullptr);
+        CATCH_REQUIRE(table->size() == 256);
+
+        snaplogger::severity_entry const & error((*table)[static_cast<std::size_t>(snaplogger::severity_t::SEVERITY_ERROR)]);
+        CATCH_REQUIRE(error.f_severity == snaplogger::get_severity("error"));
+        CATCH_REQUIRE(error.f_name == "error");
+        CATCH_REQUIRE(error.f_description == "error");
+        CATCH_REQUIRE(error.f_styles == "red");
+        CATCH_REQUIRE(error.f_ansi_style == "\x1B[31m");
+        CATCH_REQUIRE(error.f_ansi_unstyle == "\x1B[39m");
+
+        snaplogger::severity_entry const & fatal((*table)[static_cast<std::size_t>(snaplogger::severity_t::SEVERITY_FATAL)]);
+        CATCH_REQUIRE(fatal.f_name == "fatal");
+        CATCH_REQUIRE(fatal.f_ansi_style == "\x1B[31m\x1B[1m");
+        CATCH_REQUIRE(fatal.f_ansi_unstyle == "\x1B[39m\x1B[22m");
+
+        snaplogger::severity_entry const & undefined((*table)[1]);
+        CATCH_REQUIRE(undefined.f_severity == nullptr);
+        CATCH_REQUIRE(undefined.f_name.empty());
+
+        // a new severity gets a new table, the old one remains valid
+        //
+        snaplogger::severity_t const level(static_cast<snaplogger::severity_t>(203));
+        snaplogger::severity::pointer_t s(std::make_shared<snaplogger::severity>(level, "table-error"));
+        snaplogger::add_severity(s);
+        CATCH_REQUIRE((*table)[203].f_severity == nullptr);
+
+        snaplogger::severity_table_pointer_t updated(snaplogger::get_severity_table());
+        CATCH_REQUIRE(updated != table);
+        CATCH_REQUIRE((*updated)[203].f_severity == s);
+        CATCH_REQUIRE((*updated)[203].f_name == "table-error");
+        CATCH_REQUIRE((*updated)[203].f_ansi_style.empty());
+
+        s->set_styles("underline,green");
+        s->set_description("table error");
+        snaplogger::severity_table_pointer_t styled(snaplogger::get_severity_table());
+        CATCH_REQUIRE((*styled)[203].f_description == "table error");
+        CATCH_REQUIRE((*styled)[203].f_ansi_style == "\x1B[32m\x1B[4m");
+        CATCH_REQUIRE((*styled)[203].f_ansi_unstyle == "\x1B[39m\x1B[24m");
+    }
+    CATCH_END_SECTION()
+
     CATCH_START_SECTION("severity: severity.ini file matches")
     {
         // whenever I make an edit to the list of severity levels, I have to
@@ -226,101 +226,43 @@ CATCH_TEST_CASE("system_variable", "[variable][param]")
 
         buffer->clear();
 
-        f = std::make_shared<snaplogger::format>("${hostname:padding=\"q\":align=101:min_width=30} ${message}");
-        buffer->set_format(f);
-
-        snaplogger::message::pointer_t msg(std::make_shared<snaplogger::message>
-                        (::snaplogger::severity_t::SEVERITY_ERROR));
-        *msg << "The align=101 parameter is the wrong type";
+        // invalid function parameters are detected when the format
+        // gets compiled, not when a message is rendered
+        //
         CATCH_REQUIRE_THROWS_MATCHES(
-                  l->log_message(*msg)
+                  std::make_shared<snaplogger::format>("${hostname:padding=\"q\":align=101:min_width=30} ${message}")
                 , snaplogger::invalid_parameter
                 , Catch::Matchers::ExceptionMessage(
                           "logger_error: the ${...:align=<value>} parameter must be a valid string (not an integer)."));
 
-        // this is important here because we want to make sure that the
-        // `message` destructor works as expected (i.e. it does not call
-        // std::terminate() because of the throw as the align=101 is
-        // invalid)
-        //
-        msg.reset();
-
-        buffer->clear();
-
-        f = std::make_shared<snaplogger::format>("${hostname:padding=\"t\":align=justify:min_width=30} ${message}");
-        buffer->set_format(f);
-
-        msg = std::make_shared<snaplogger::message>
-                        (::snaplogger::severity_t::SEVERITY_ERROR);
-        *msg << "Try align=\"justify\" which has to fail.";
         CATCH_REQUIRE_THROWS_MATCHES(
-                  l->log_message(*msg)
+                  std::make_shared<snaplogger::format>("${hostname:padding=\"t\":align=justify:min_width=30} ${message}")
                 , snaplogger::invalid_parameter
                 , Catch::Matchers::ExceptionMessage(
                           "logger_error: the ${...:align=left|center|right} was expected, got \"justify\"."));
 
-        buffer->clear();
-
-        f = std::make_shared<snaplogger::format>("${hostname:padding=\"q\":align=left:min_width=wide} ${message}");
-        buffer->set_format(f);
-
-        msg = std::make_shared<snaplogger::message>
-                        (::snaplogger::severity_t::SEVERITY_ERROR);
-        *msg << "The min_width=wide parameter is the wrong type";
         CATCH_REQUIRE_THROWS_MATCHES(
-                  l->log_message(*msg)
+                  std::make_shared<snaplogger::format>("${hostname:padding=\"q\":align=left:min_width=wide} ${message}")
                 , snaplogger::invalid_parameter
                 , Catch::Matchers::ExceptionMessage(
                           "logger_error: the ${...:min_width=<value>} parameter must be a valid integer."));
 
-        // this is important here because we want to make sure that the
-        // `message` destructor works as expected (i.e. it does not call
-        // std::terminate() because of the throw as the align=101 is
-        // invalid)
-        //
-        msg.reset();
-
-        buffer->clear();
-
-        f = std::make_shared<snaplogger::format>("${hostname:padding=99:align=left:min_width=wide} ${message}");
-        buffer->set_format(f);
-
-        msg = std::make_shared<snaplogger::message>
-                        (::snaplogger::severity_t::SEVERITY_ERROR);
-        *msg << "The padding=... accepts a number between 0 and 9 inclusive";
         CATCH_REQUIRE_THROWS_MATCHES(
-                  l->log_message(*msg)
+                  std::make_shared<snaplogger::format>("${hostname:padding=99:align=left:min_width=wide} ${message}")
                 , snaplogger::invalid_parameter
                 , Catch::Matchers::ExceptionMessage(
                           "logger_error: the ${...:padding=<value>} when set to a number must be one digit ('0' to '9'), not \"99\"."));
 
-        // this is important here because we want to make sure that the
-        // `message` destructor works as expected (i.e. it does not call
-        // std::terminate() because of the throw as the align=101 is
-        // invalid)
-        //
-        msg.reset();
-
-        buffer->clear();
-
-        f = std::make_shared<snaplogger::format>("${hostname:padding='abc':align=left:min_width=wide} ${message}");
-        buffer->set_format(f);
-
-        msg = std::make_shared<snaplogger::message>
-                        (::snaplogger::severity_t::SEVERITY_ERROR);
-        *msg << "The padding=... accepts one character";
         CATCH_REQUIRE_THROWS_MATCHES(
-                  l->log_message(*msg)
+                  std::make_shared<snaplogger::format>("${hostname:padding='abc':align=left:min_width=wide} ${message}")
                 , snaplogger::invalid_parameter
                 , Catch::Matchers::ExceptionMessage(
                           "logger_error: the ${...:padding=' '} must be exactly one character, not \"abc\"."));
 
-        // this is important here because we want to make sure that the
-        // `message` destructor works as expected (i.e. it does not call
-        // std::terminate() because of the throw as the align=101 is
-        // invalid)
+        // the format in place is still the last valid one
         //
-        msg.reset();
+        SNAP_LOG_ERROR << "Still Working" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(buffer->str() == std::string(host) + " zzzzzzzzStill Working (A)\n");
 
         l->reset();
     }
@@ -594,18 +536,17 @@ CATCH_TEST_CASE("system_variable", "[variable][param]")
 
         buffer->set_config(opts);
 
-        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${severity:format=invalid} ${message} (${severity:format=alpha})"));
-        buffer->set_format(f);
-
-        l->add_appender(buffer);
-
+        // the error is detected when the format gets compiled
+        //
         CATCH_REQUIRE_THROWS_MATCHES(
-                  SNAP_LOG_MAJOR << "<- severity tag for systemd/syslog" << SNAP_LOG_SEND
+                  std::make_shared<snaplogger::format>("${severity:format=invalid} ${message} (${severity:format=alpha})")
                 , snaplogger::invalid_variable
                 , Catch::Matchers::ExceptionMessage(
                       "logger_error: the ${severity:format=alpha|number|systemd}"
                       " variable cannot be set to \"invalid\"."));
 
+        l->add_appender(buffer);
+
         CATCH_REQUIRE(buffer->str() == "");
 
         l->reset();
@@ -654,6 +595,58 @@ CATCH_TEST_CASE("system_variable", "[variable][param]")
     }
     CATCH_END_SECTION()
 
+    CATCH_START_SECTION("variable: values without functions are not converted")
+    {
+        snaplogger::set_diagnostic(snaplogger::DIAG_KEY_PROGNAME, "no-functions");
+
+        snaplogger::logger::pointer_t l(snaplogger::logger::get_instance());
+        snaplogger::buffer_appender::pointer_t buffer(std::make_shared<snaplogger::buffer_appender>("test-buffer"));
+
+        char const * cargv[] =
+        {
+            "/usr/bin/daemon",
+            nullptr
+        };
+        int const argc(sizeof(cargv) / sizeof(cargv[0]) - 1);
+        char ** argv = const_cast<char **>(cargv);
+
+        advgetopt::options_environment environment_options;
+        environment_options.f_project_name = "test-logger";
+        environment_options.f_environment_flags = advgetopt::GETOPT_ENVIRONMENT_FLAG_SYSTEM_PARAMETERS;
+        advgetopt::getopt opts(environment_options);
+        opts.parse_program_name(argv);
+        opts.parse_arguments(argc, argv, advgetopt::option_source_t::SOURCE_COMMAND_LINE);
+
+        buffer->set_config(opts);
+
+        // without any function, the value is not converted to UTF-32
+        // so invalid UTF-8 goes through as is
+        //
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>("${message} ${progname:upper}"));
+        buffer->set_format(f);
+
+        l->add_appender(buffer);
+
+        SNAP_LOG_ERROR << "Byte 0xFF \xFF is left alone" << SNAP_LOG_SEND;
+        CATCH_REQUIRE(buffer->str() == "Byte 0xFF \xFF is left alone NO-FUNCTIONS\n");
+
+        // parameters which are not functions are ignored by the pipeline
+        //
+        snaplogger::variable::pointer_t var(snaplogger::get_variable("message"));
+        CATCH_REQUIRE(var != nullptr);
+        var->add_param(std::make_shared<snaplogger::param>("not_a_function"));
+        var->add_param(std::make_shared<snaplogger::param>("upper"));
+        CATCH_REQUIRE(var->get_params().size() == 2);
+        CATCH_REQUIRE(&var->get_params() == &var->get_params());
+
+        snaplogger::message msg(snaplogger::severity_t::SEVERITY_ERROR);
+        msg << "Only upper applies";
+        CATCH_REQUIRE(var->get_value(msg) == "ONLY UPPER APPLIES");
+
+        l->reset();
+    }
+    CATCH_END_SECTION()
+
     CATCH_START_SECTION("variable: time:process_ms")
     {
         snaplogger::set_diagnostic(snaplogger::DIAG_KEY_PROGNAME, "on_repeat");
@@ -721,6 +714,124 @@ CATCH_TEST_CASE("system_variable", "[variable][param]")
 
 
 
+CATCH_TEST_CASE("compiled_format", "[variable][format]")
+{
+    CATCH_START_SECTION("variable: invalid variable parameters are detected by the format")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  std::make_shared<snaplogger::format>("${date:unknown}")
+                , snaplogger::invalid_variable
+                , Catch::Matchers::ExceptionMessage(
+                          "logger_error: the ${date:...} variable first parameter must be its name parameter."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  std::make_shared<snaplogger::format>("${time:unknown}")
+                , snaplogger::invalid_variable
+                , Catch::Matchers::ExceptionMessage(
+                          "logger_error: the ${time:...} variable first parameter must be its name parameter."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  std::make_shared<snaplogger::format>("${fields:format=xml}")
+                , snaplogger::invalid_variable
+                , Catch::Matchers::ExceptionMessage(
+                          "logger_error: the ${fields:format=json|shell} variable cannot be set to \"xml\"."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  std::make_shared<snaplogger::format>("${env}")
+                , snaplogger::invalid_variable
+                , Catch::Matchers::ExceptionMessage(
+                          "logger_error: the ${env:...} variable must have a \"name\" parameter."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  std::make_shared<snaplogger::format>("${diagnostic:nested=deep}")
+                , snaplogger::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "logger_error: the ${...:nested=<value>} parameter must be a valid integer."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("variable: fields are found by their interned name")
+    {
+        snaplogger::format::pointer_t f(std::make_shared<snaplogger::format>(
+                    "${field:name=color}/${field:name=_line}/${field:name=id}/${field:name=missing}"));
+
+        snaplogger::message msg(snaplogger::severity_t::SEVERITY_ERROR);
+        msg.add_field("color", "blue");
+        msg.set_line(123);
+        CATCH_REQUIRE(f->process_message(msg) == "blue/123/" + std::to_string(msg.get_id()) + "/");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("variable: identical formats are shared")
+    {
+        snaplogger::format::pointer_t a(snaplogger::get_shared_format("${severity}: ${message} [shared]"));
+        snaplogger::format::pointer_t b(snaplogger::get_shared_format("${severity}: ${message} [shared]"));
+        snaplogger::format::pointer_t c(snaplogger::get_shared_format("${severity}: ${message} [other]"));
+        CATCH_REQUIRE(a == b);
+        CATCH_REQUIRE(a != c);
+        CATCH_REQUIRE(a->get_format() == "${severity}: ${message} [shared]");
+
+        // the cache keeps formats only while they are in use
+        //
+        a.reset();
+        b.reset();
+        snaplogger::format::pointer_t d(snaplogger::get_shared_format("${severity}: ${message} [other]"));
+        CATCH_REQUIRE(d == c);
+        snaplogger::format::pointer_t e(snaplogger::get_shared_format("${severity}: ${message} [shared]"));
+        CATCH_REQUIRE(e->get_format() == "${severity}: ${message} [shared]");
+
+        // an invalid format is not cached
+        //
+        CATCH_REQUIRE_THROWS_AS(
+                  snaplogger::get_shared_format("${severity:format=invalid}")
+                , snaplogger::invalid_variable);
+        CATCH_REQUIRE_THROWS_AS(
+                  snaplogger::get_shared_format("${severity:format=invalid}")
+                , snaplogger::invalid_variable);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("variable: registering a function resets the shared formats")
+    {
+        class shout_function final
+            : public snaplogger::function
+        {
+        public:
+            shout_function()
+                : function("shout")
+            {
+            }
+
+            virtual void apply(
+                  ::snaplogger::message const & msg
+                , ::snaplogger::function_data & d
+                , ::snaplogger::param::pointer_t const & p) override
+            {
+                snapdev::NOT_USED(msg, p);
+                d.set_value(std::string("[shouted]"));
+            }
+        };
+
+        snaplogger::message msg(snaplogger::severity_t::SEVERITY_ERROR);
+        msg << "quiet";
+
+        snaplogger::format::pointer_t before(snaplogger::get_shared_format("${message:shout=yes}"));
+        CATCH_REQUIRE(before->process_message(msg) == "quiet");
+
+        snaplogger::register_function(std::make_shared<shout_function>());
+
+        // the format in use is not modified, the next user gets a new one
+        //
+        snaplogger::format::pointer_t after(snaplogger::get_shared_format("${message:shout=yes}"));
+        CATCH_REQUIRE(after != before);
+        CATCH_REQUIRE(before->process_message(msg) == "quiet");
+        CATCH_REQUIRE(after->process_message(msg) == "[shouted]");
+    }
+    CATCH_END_SECTION()
+}
+
+
+
 CATCH_TEST_CASE("duplicate_factory", "[variable][factory]")
 {
     CATCH_START_SECTION("variable: attempt dynamically creating a factory which already exists")